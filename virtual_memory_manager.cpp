@@ -1,315 +1,4894 @@
-#include <iostream>
-#include <vector>
-#include <queue>
-#include <list>
-#include <unordered_map>
-#include <string>
-#include <iomanip>
-#include <limits>
-
-/**
- * @brief Represents a memory segment (for segmentation simulation)
- */
-struct Segment {
-    std::string name;
-    size_t base;
-    size_t limit;
-    Segment(const std::string& n, size_t b, size_t l) : name(n), base(b), limit(l) {}
-};
-
-/**
- * @brief Represents a page table entry
- */
-struct PageTableEntry {
-    int frameNumber; ///< Frame number if page is loaded
-    bool valid;      ///< Valid bit
-    PageTableEntry() : frameNumber(-1), valid(false) {}
-};
-
-/**
- * @brief Page replacement policy
- */
-enum class ReplacementPolicy {
-    FIFO,
-    LRU
-};
-
-/**
- * @brief Simulates a Virtual Memory Manager with paging, segmentation, and page replacement
- */
-class VirtualMemoryManager {
-    size_t pageSize;
-    size_t numFrames;
-    size_t numPages;
-    std::vector<Segment> segments;
-    std::vector<PageTableEntry> pageTable;
-    std::vector<int> frameTable; ///< frameTable[frame] = page number or -1
-    ReplacementPolicy policy;
-    // FIFO
-    std::queue<size_t> fifoQueue;
-    // LRU
-    std::list<size_t> lruList; // most recently used at front
-    std::unordered_map<size_t, std::list<size_t>::iterator> lruMap; // pageNum -> iterator in lruList
-    size_t pageFaults;
-    size_t accesses;
-
-public:
-    /**
-     * @brief Constructor
-     * @param memSize Total memory size
-     * @param pageSz Page size
-     * @param segNames Names of segments
-     * @param pol Page replacement policy
-     */
-    explicit VirtualMemoryManager(size_t memSize, size_t pageSz, const std::vector<std::string>& segNames, ReplacementPolicy pol)
-        : pageSize(pageSz), pageFaults(0), accesses(0), policy(pol) {
-        numFrames = memSize / pageSize;
-        numPages = memSize / pageSize;
-        pageTable.resize(numPages);
-        frameTable.assign(numFrames, -1);
-        // Create segments
-        size_t nSegments = segNames.size();
-        size_t segSize = memSize / nSegments;
-        for (size_t i = 0; i < nSegments; ++i) {
-            segments.emplace_back(segNames[i], i * segSize, segSize);
-        }
-    }
-
-    /**
-     * @brief Display all segments
-     */
-    void showSegments() const {
-        std::cout << "\nSegments:\n";
-        for (size_t i = 0; i < segments.size(); ++i) {
-            const auto& seg = segments[i];
-            std::cout << i << ": " << seg.name << ": Base = " << seg.base << ", Limit = " << seg.limit << '\n';
-        }
-    }
-
-    /**
-     * @brief Display the page table
-     */
-    void showPageTable() const {
-        std::cout << "\nPage Table (Page -> Frame):\n";
-        for (size_t i = 0; i < pageTable.size(); ++i) {
-            if (pageTable[i].valid)
-                std::cout << "Page " << i << " -> Frame " << pageTable[i].frameNumber << '\n';
-            else
-                std::cout << "Page " << i << " -> Not in memory\n";
-        }
-    }
-
-    /**
-     * @brief Display the frame table
-     */
-    void showFrames() const {
-        std::cout << "\nFrames (Frame -> Page):\n";
-        for (size_t i = 0; i < frameTable.size(); ++i) {
-            if (frameTable[i] != -1)
-                std::cout << "Frame " << i << " -> Page " << frameTable[i] << '\n';
-            else
-                std::cout << "Frame " << i << " -> Empty\n";
-        }
-    }
-
-    /**
-     * @brief Access a logical address (segment + offset)
-     * @param segIdx Segment index
-     * @param offset Offset within segment
-     */
-    void accessAddress(size_t segIdx, size_t offset) {
-        if (segIdx >= segments.size()) {
-            std::cout << "Invalid segment index!\n";
-            return;
-        }
-        const Segment& seg = segments[segIdx];
-        if (offset >= seg.limit) {
-            std::cout << "Offset out of bounds!\n";
-            return;
-        }
-        size_t logicalAddr = seg.base + offset;
-        size_t pageNum = logicalAddr / pageSize;
-        size_t pageOffset = logicalAddr % pageSize;
-        ++accesses;
-        if (!pageTable[pageNum].valid) {
-            ++pageFaults;
-            handlePageFault(pageNum);
-            std::cout << "Page fault occurred! Loaded page " << pageNum << " into memory.\n";
-        }
-        if (policy == ReplacementPolicy::LRU) updateLRU(pageNum);
-        int frameNum = pageTable[pageNum].frameNumber;
-        size_t physicalAddr = static_cast<size_t>(frameNum) * pageSize + pageOffset;
-        std::cout << "Logical Address: " << logicalAddr << " (Segment " << segIdx << ", Offset " << offset << ")\n";
-        std::cout << "Physical Address: " << physicalAddr << " (Frame " << frameNum << ", Offset " << pageOffset << ")\n";
-    }
-
-    /**
-     * @brief Handle a page fault using selected replacement policy
-     * @param pageNum The page number to load
-     */
-    void handlePageFault(size_t pageNum) {
-        int freeFrame = -1;
-        for (size_t i = 0; i < frameTable.size(); ++i) {
-            if (frameTable[i] == -1) {
-                freeFrame = static_cast<int>(i);
-                break;
-            }
-        }
-        if (freeFrame == -1) {
-            if (policy == ReplacementPolicy::FIFO) {
-                size_t victimPage = fifoQueue.front(); fifoQueue.pop();
-                freeFrame = pageTable[victimPage].frameNumber;
-                pageTable[victimPage].valid = false;
-                frameTable[freeFrame] = -1;
-            } else if (policy == ReplacementPolicy::LRU) {
-                size_t victimPage = lruList.back();
-                lruList.pop_back();
-                lruMap.erase(victimPage);
-                freeFrame = pageTable[victimPage].frameNumber;
-                pageTable[victimPage].valid = false;
-                frameTable[freeFrame] = -1;
-            }
-        }
-        // Load page into frame
-        pageTable[pageNum].frameNumber = freeFrame;
-        pageTable[pageNum].valid = true;
-        frameTable[freeFrame] = static_cast<int>(pageNum);
-        if (policy == ReplacementPolicy::FIFO) fifoQueue.push(pageNum);
-        else if (policy == ReplacementPolicy::LRU) addLRU(pageNum);
-    }
-
-    /**
-     * @brief Add a page to the LRU list
-     */
-    void addLRU(size_t pageNum) {
-        lruList.push_front(pageNum);
-        lruMap[pageNum] = lruList.begin();
-    }
-
-    /**
-     * @brief Update LRU list on page access
-     */
-    void updateLRU(size_t pageNum) {
-        auto it = lruMap.find(pageNum);
-        if (it != lruMap.end()) {
-            lruList.erase(it->second);
-            lruList.push_front(pageNum);
-            lruMap[pageNum] = lruList.begin();
-        }
-    }
-
-    /**
-     * @brief Show statistics (accesses, page faults, fault rate)
-     */
-    void showStats() const {
-        std::cout << "\nStatistics:\n";
-        std::cout << "Total accesses: " << accesses << '\n';
-        std::cout << "Page faults: " << pageFaults << '\n';
-        if (accesses > 0)
-            std::cout << "Page fault rate: " << std::fixed << std::setprecision(2) << (100.0 * pageFaults / accesses) << "%\n";
-    }
-
-    size_t getNumSegments() const { return segments.size(); }
-    size_t getSegmentLimit(size_t segIdx) const { return segments[segIdx].limit; }
-    std::string getSegmentName(size_t segIdx) const { return segments[segIdx].name; }
-};
-
-/**
- * @brief Menu options for the CLI
- */
-enum MenuOption {
-    SHOW_SEGMENTS = 1,
-    SHOW_PAGETABLE = 2,
-    SHOW_FRAMES = 3,
-    ACCESS_ADDRESS = 4,
-    SHOW_STATS = 5,
-    EXIT = 0
-};
-
-void menu() {
-    std::cout << "\nVirtual Memory Manager Simulator\n";
-    std::cout << "1. Show Segments\n";
-    std::cout << "2. Show Page Table\n";
-    std::cout << "3. Show Frames\n";
-    std::cout << "4. Access Address\n";
-    std::cout << "5. Show Statistics\n";
-    std::cout << "0. Exit\n";
-    std::cout << "Enter choice: ";
-}
-
-int main() {
-    size_t memSize, pageSize, nSegments;
-    std::cout << "Enter total memory size (bytes): ";
-    std::cin >> memSize;
-    std::cout << "Enter page size (bytes): ";
-    std::cin >> pageSize;
-    std::cout << "Enter number of segments: ";
-    std::cin >> nSegments;
-    std::vector<std::string> segNames;
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    for (size_t i = 0; i < nSegments; ++i) {
-        std::string name;
-        std::cout << "Enter name for segment " << i << ": ";
-        std::getline(std::cin, name);
-        if (name.empty()) name = "Segment" + std::to_string(i);
-        segNames.push_back(name);
-    }
-    int polChoice = 0;
-    std::cout << "Select page replacement policy (1 = FIFO, 2 = LRU): ";
-    std::cin >> polChoice;
-    ReplacementPolicy policy = (polChoice == 2) ? ReplacementPolicy::LRU : ReplacementPolicy::FIFO;
-    VirtualMemoryManager vmm(memSize, pageSize, segNames, policy);
-    int choice = -1;
-    while (true) {
-        menu();
-        std::cin >> choice;
-        if (!std::cin) {
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::cout << "Invalid input!\n";
-            continue;
-        }
-        switch (choice) {
-            case SHOW_SEGMENTS:
-                vmm.showSegments();
-                break;
-            case SHOW_PAGETABLE:
-                vmm.showPageTable();
-                break;
-            case SHOW_FRAMES:
-                vmm.showFrames();
-                break;
-            case ACCESS_ADDRESS: {
-                size_t segIdx, offset;
-                vmm.showSegments();
-                std::cout << "Enter segment index (0-" << vmm.getNumSegments() - 1 << "): ";
-                std::cin >> segIdx;
-                if (!std::cin || segIdx >= vmm.getNumSegments()) {
-                    std::cin.clear();
-                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                    std::cout << "Invalid segment index!\n";
-                    break;
-                }
-                std::cout << "Enter offset (0-" << vmm.getSegmentLimit(segIdx) - 1 << "): ";
-                std::cin >> offset;
-                if (!std::cin || offset >= vmm.getSegmentLimit(segIdx)) {
-                    std::cin.clear();
-                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                    std::cout << "Invalid offset!\n";
-                    break;
-                }
-                vmm.accessAddress(segIdx, offset);
-                break;
-            }
-            case SHOW_STATS:
-                vmm.showStats();
-                break;
-            case EXIT:
-                std::cout << "Exiting...\n";
-                return 0;
-            default:
-                std::cout << "Invalid choice!\n";
-        }
-    }
-    return 0;
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cctype>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Direction in which a segment grows on demand
+ */
+enum class SegmentGrowth {
+    None, ///< Fixed size
+    Up,   ///< Heap-like: grows towards higher addresses
+    Down  ///< Stack-like: grows towards lower addresses; offset 0 is the top of the segment
+};
+
+/**
+ * @brief Represents a page table entry
+ */
+struct PageTableEntry {
+    int frameNumber; ///< Frame number if page is loaded
+    bool valid;      ///< Valid bit
+    bool dirty;      ///< Modified since it was last written to swap
+    bool merged;     ///< Mapped read-only to a frame shared by same-page merging
+    bool prefetched; ///< Loaded by a WILLNEED hint and not accessed since
+    bool locked;     ///< Pinned by mlock: resident and never chosen for replacement
+    uint64_t shadow; ///< Shadow entry of an evicted page: workingset clock at eviction (0 = none)
+    bool accessed;   ///< Accessed bit: set on every access, cleared by the access monitor when it samples the page
+    PageTableEntry()
+        : frameNumber(-1), valid(false), dirty(false), merged(false), prefetched(false), locked(false), shadow(0), accessed(false) {}
+};
+
+/**
+ * @brief madvise-style hints on a range of a segment
+ */
+enum class Advice {
+    Normal,     ///< Default readahead
+    Sequential, ///< Expect sequential access: double the readahead window
+    Random,     ///< Expect random access: no readahead
+    WillNeed,   ///< Load the pages now
+    DontNeed,   ///< Drop the pages; anonymous pages read as zeros afterwards
+    Cold        ///< Move the pages to the oldest end of their inactive list
+};
+
+/**
+ * @brief A memory segment with its own page table (paged segmentation)
+ *
+ * Page-table entry i maps segment offsets [i * page size, (i + 1) * page size),
+ * counted from the top for grows-down segments, so entries keep their index when the
+ * segment grows or moves. A segment's pages are pageFrames base pages each and
+ * occupy that many contiguous, aligned frames when resident. A file-backed segment
+ * maps consecutive pages of a file starting at fileOffset, through the page cache.
+ */
+struct Segment {
+    std::string name;
+    size_t base;
+    size_t limit;
+    bool inUse; ///< false once destroyed; the slot is reused by the next created segment
+    SegmentGrowth growth;
+    size_t pageFrames; ///< Base pages per page of this segment
+    std::vector<PageTableEntry> pageTable;
+    long file;         ///< Mapped file, or -1 for anonymous memory
+    size_t fileOffset; ///< File page mapped by page-table entry 0
+    Advice access;     ///< Normal, Sequential or Random: sets the readahead window
+    size_t space;      ///< Address space (process) the segment belongs to
+    size_t accesses;
+    size_t faults;
+    size_t majorFaults;
+    size_t tlbMisses;
+    Segment(const std::string& n, size_t b, size_t l, size_t pages, size_t frames = 1)
+        : name(n), base(b), limit(l), inUse(true), growth(SegmentGrowth::None), pageFrames(frames), pageTable(pages),
+          file(-1), fileOffset(0), access(Advice::Normal), space(0), accesses(0), faults(0), majorFaults(0), tlbMisses(0) {}
+};
+
+/**
+ * @brief Placement policy for segments created at runtime
+ */
+enum class FitPolicy {
+    FirstFit, ///< Lowest-addressed hole that fits
+    BestFit,  ///< Smallest hole that fits
+    NextFit   ///< First hole that fits, searching on from the previous allocation
+};
+
+
+/**
+ * @brief Page replacement policy
+ */
+enum class ReplacementPolicy {
+    FIFO, ///< Pages are never activated; each inactive list keeps load order
+    LRU,  ///< Two-list LRU: a second access activates an inactive page
+    CFLRU ///< LRU that evicts clean pages before dirty ones within a clean-first window at the LRU end
+};
+
+/**
+ * @brief Replacement lists (Linux-style): active and inactive lists for anonymous and file pages
+ *
+ * Pages pinned by mlock sit on the unevictable list, which is never scanned for victims.
+ */
+enum class LruList {
+    InactiveAnon,
+    ActiveAnon,
+    InactiveFile,
+    ActiveFile,
+    Unevictable
+};
+
+/**
+ * @brief Outcome of a page fault
+ */
+enum class FaultResult {
+    Minor,      ///< Served without reading from disk
+    Major,      ///< Read from swap or a file
+    OutOfMemory ///< No frame could be freed: every resident page is pinned
+};
+
+/**
+ * @brief Two-tier physical memory settings (fast DRAM + slow tier such as CXL memory)
+ *
+ * Frames [0, fastFrames) form the fast tier and the remaining frames the slow tier.
+ * Slow-tier pages are promoted once sampled accesses reach promoteThreshold.
+ */
+struct TieringConfig {
+    size_t fastFrames;       ///< Frames in the fast tier (0 = single tier)
+    double fastLatencyNs;    ///< Access latency of the fast tier
+    double slowLatencyNs;    ///< Access latency of the slow tier
+    size_t sampleInterval;   ///< Sample one out of every sampleInterval accesses
+    size_t promoteThreshold; ///< Samples needed to promote a slow-tier page
+    TieringConfig() : fastFrames(0), fastLatencyNs(80.0), slowLatencyNs(250.0), sampleInterval(16), promoteThreshold(2) {}
+};
+
+/**
+ * @brief Address translation mode
+ */
+enum class VirtMode {
+    Native, ///< One page table maps virtual pages to frames
+    Nested, ///< Guest page table maps to guest frames, host page table maps those to host frames
+    Shadow  ///< Hypervisor-maintained shadow table maps guest pages straight to host frames
+};
+
+/**
+ * @brief TLB, page-walk and virtualization settings
+ *
+ * A TLB miss walks guestLevels page-table levels natively. Under nested paging every
+ * guest level, and the final guest-physical address, is itself translated by a
+ * hostLevels walk: (guestLevels + 1) * (hostLevels + 1) - 1 references. Under shadow
+ * paging a miss walks only the shadow table, but every guest page-table write traps
+ * to the hypervisor to keep the shadow table in sync. Huge pages remove one level
+ * from their walk; a TLB entry (or shadow mapping) covers a huge page only when every
+ * translation stage uses huge pages. Guest huge pages are the pages of segments with
+ * a page size above the base page size.
+ */
+struct PagingConfig {
+    VirtMode mode;
+    size_t tlbEntries;     ///< TLB capacity (0 = no TLB)
+    size_t guestLevels;    ///< Levels of the (guest) page table
+    size_t hostLevels;     ///< Levels of the host page table
+    bool hostHugePages;    ///< Host maps guest memory with huge pages
+    size_t hugePageFactor; ///< Base pages per host huge page
+    size_t hostFrames;     ///< Host frames backing guest memory (0 = one per guest frame)
+    double walkRefNs;      ///< Cost of one page-walk memory reference
+    double vmExitNs;       ///< Cost of a VM exit (host fault or shadow sync trap)
+    PagingConfig()
+        : mode(VirtMode::Native), tlbEntries(64), guestLevels(4), hostLevels(4), hostHugePages(false),
+          hugePageFactor(512), hostFrames(0), walkRefNs(25.0), vmExitNs(1500.0) {}
+};
+
+/**
+ * @brief Fully associative TLB with LRU replacement, caching translations by virtual page key
+ */
+class Tlb {
+    size_t capacity;
+    std::list<uint64_t> order; // most recently used at front
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> entries;
+
+public:
+    size_t hits;
+    size_t misses;
+
+    explicit Tlb(size_t cap) : capacity(cap), hits(0), misses(0) {}
+
+    bool contains(uint64_t key) const { return entries.count(key) > 0; }
+
+    size_t size() const { return entries.size(); }
+
+    template <typename F>
+    void forEach(F visit) const {
+        for (uint64_t key : order) visit(key);
+    }
+
+    /**
+     * @brief Look up a translation, counting the hit or miss
+     */
+    bool lookup(uint64_t key) {
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            ++misses;
+            return false;
+        }
+        order.splice(order.begin(), order, it->second);
+        ++hits;
+        return true;
+    }
+
+    /**
+     * @brief Cache a translation, replacing the least recently used one when full
+     */
+    void insert(uint64_t key) {
+        if (capacity == 0 || entries.count(key)) return;
+        if (entries.size() == capacity) {
+            entries.erase(order.back());
+            order.pop_back();
+        }
+        order.push_front(key);
+        entries[key] = order.begin();
+    }
+
+    /**
+     * @return Whether the translation was cached
+     */
+    bool invalidate(uint64_t key) {
+        auto it = entries.find(key);
+        if (it == entries.end()) return false;
+        order.erase(it->second);
+        entries.erase(it);
+        return true;
+    }
+
+    void flush() {
+        order.clear();
+        entries.clear();
+    }
+
+    void setCapacity(size_t cap) {
+        capacity = cap;
+        flush();
+    }
+};
+
+/**
+ * @brief Same-page merging (KSM) scanner settings
+ *
+ * Every scanInterval accesses the scanner hashes up to pagesToScan resident pages,
+ * limited so that its simulated CPU time stays within cpuBudgetPercent of the memory
+ * access time simulated so far.
+ */
+struct KsmConfig {
+    size_t pagesToScan;      ///< Pages scanned per wake-up (0 = scanner stopped)
+    size_t scanInterval;     ///< Accesses between wake-ups
+    double hashCostNs;       ///< Simulated CPU time to hash and compare one page
+    double cpuBudgetPercent; ///< Cap on scanner CPU time relative to simulated run time
+    KsmConfig() : pagesToScan(0), scanInterval(100), hashCostNs(500.0), cpuBudgetPercent(10.0) {}
+};
+
+/**
+ * @brief Free-frame watermarks of the fast tier (kswapd-style reclaim) and reclaim batching
+ *
+ * An allocation that would leave fewer than minFrames free reclaims directly and
+ * stalls the faulting access. Once fewer than lowFrames are free, kswapd wakes and
+ * reclaims once before every access until highFrames are free. Each reclaim
+ * invocation picks up to batch victims in one pass and submits their writebacks as
+ * one I/O.
+ */
+struct ReclaimConfig {
+    size_t minFrames;        ///< Direct reclaim keeps this many frames free
+    size_t lowFrames;        ///< kswapd wakes below this many free frames
+    size_t highFrames;       ///< kswapd sleeps again at this many free frames (0 = no kswapd)
+    size_t batch;            ///< Victims picked and evicted per reclaim invocation
+    double invocationNs;     ///< Fixed cost of one invocation (list locking, victim selection setup)
+    double reclaimNsPerPage; ///< Cost of unmapping one page
+    double ioSubmitNs;       ///< Latency of one writeback I/O submission
+    double ioPageNs;         ///< Transfer time of one written page
+    double ioReadNs;         ///< Time to read one page from swap or a file
+    ReclaimConfig()
+        : minFrames(0), lowFrames(0), highFrames(0), batch(1), invocationNs(2000.0), reclaimNsPerPage(500.0),
+          ioSubmitNs(20000.0), ioPageNs(1000.0), ioReadNs(1000.0) {}
+};
+
+/**
+ * @brief Dirty page writeback settings (flusher threads and dirty throttling)
+ *
+ * Every interval accesses the flusher writes back pages dirty for at least
+ * expireAccesses, then the oldest dirty pages while more than backgroundRatio
+ * percent of the frames are dirty. A write that pushes dirty pages above dirtyRatio
+ * percent throttles the writer, which writes back the oldest pages itself until the
+ * background limit is met.
+ */
+struct WritebackConfig {
+    size_t interval;          ///< Accesses between flusher wake-ups (0 = no flusher, no throttling)
+    size_t expireAccesses;    ///< Age at which a dirty page is written back
+    unsigned backgroundRatio; ///< Dirty share of frames (%) above which the flusher writes regardless of age
+    unsigned dirtyRatio;      ///< Dirty share of frames (%) above which writers are throttled (0 = never)
+    WritebackConfig() : interval(0), expireAccesses(3000), backgroundRatio(10), dirtyRatio(20) {}
+};
+
+/**
+ * @brief Region-based access monitor settings (DAMON-style)
+ *
+ * Every sampleInterval accesses the monitor checks the accessed bit of one sampled
+ * page per region. After aggregateSamples samples, adjacent regions with similar
+ * access counts are merged, regions that stayed cold for coldAge aggregations are
+ * paged out, and regions are split again while there are fewer than half of
+ * maxRegions, so the monitoring cost is bounded by the region count rather than the
+ * memory size.
+ */
+struct DamonConfig {
+    size_t sampleInterval;   ///< Accesses between samples (0 = monitor off)
+    size_t aggregateSamples; ///< Samples per aggregation
+    size_t minRegions;
+    size_t maxRegions;
+    size_t coldAge;          ///< Aggregations without access before a region is paged out (0 = no proactive reclaim)
+    DamonConfig() : sampleInterval(0), aggregateSamples(20), minRegions(10), maxRegions(100), coldAge(0) {}
+};
+
+/**
+ * @brief Proactive reclaim of idle pages
+ *
+ * Every scanInterval accesses the idle-page bitmap is scanned and cleared; a page
+ * whose bit stayed clear for idleScans scans in a row is reclaimed ahead of memory
+ * pressure, to the compressed pool or the backing store like any eviction.
+ */
+struct IdleReclaimConfig {
+    size_t scanInterval; ///< Accesses between idle scans (0 = off)
+    size_t idleScans;    ///< Idle scans in a row before a page is reclaimed
+    IdleReclaimConfig() : scanInterval(0), idleScans(4) {}
+};
+
+/**
+ * @brief Cost of TLB shootdowns between simulated cores
+ *
+ * A core that unmaps or changes a present page interrupts every other core that may
+ * cache the address space's translations and waits for all of them to acknowledge.
+ * Reclaim can instead queue the flushes of a whole pass and send each core one IPI.
+ */
+struct ShootdownConfig {
+    double ipiNs;      ///< Initiator's wait from sending the IPIs to the last acknowledgement
+    double handlerNs;  ///< Time a target core spends in the flush interrupt
+    bool batchReclaim; ///< One IPI per core per reclaim pass instead of one per page
+    ShootdownConfig() : ipiNs(2000.0), handlerNs(1000.0), batchReclaim(false) {}
+};
+
+/**
+ * @brief Headline counters of a finished replay, aggregated by batch runs
+ */
+struct ReplaySummary {
+    size_t accesses;
+    size_t pageFaults;
+    size_t majorFaults;
+    size_t evictions;
+    size_t tlbHits;
+    size_t tlbMisses;
+    double simNs; ///< Simulated time
+    ReplaySummary() : accesses(0), pageFaults(0), majorFaults(0), evictions(0), tlbHits(0), tlbMisses(0), simNs(0.0) {}
+};
+
+/**
+ * @brief Compress a buffer into LZ4-style sequences of literal runs and back-references
+ *
+ * Each sequence is a token (literal length << 4 | match length - 4), extra length
+ * bytes for nibbles that saturate at 15, the literals, and a 2-byte match offset.
+ * The final sequence carries literals only.
+ */
+std::vector<unsigned char> lzCompress(const unsigned char* src, size_t n) {
+    const size_t MIN_MATCH = 4;
+    const size_t HASH_BITS = 12;
+    std::vector<long> table(static_cast<size_t>(1) << HASH_BITS, -1);
+    std::vector<unsigned char> out;
+    auto read32 = [src](size_t pos) {
+        return static_cast<unsigned>(src[pos]) | static_cast<unsigned>(src[pos + 1]) << 8 |
+               static_cast<unsigned>(src[pos + 2]) << 16 | static_cast<unsigned>(src[pos + 3]) << 24;
+    };
+    auto putLength = [&out](size_t len) {
+        for (; len >= 255; len -= 255) out.push_back(255);
+        out.push_back(static_cast<unsigned char>(len));
+    };
+    size_t i = 0, anchor = 0;
+    while (i + MIN_MATCH <= n) {
+        unsigned seq = read32(i);
+        size_t h = (seq * 2654435761u) >> (32 - HASH_BITS);
+        long cand = table[h];
+        table[h] = static_cast<long>(i);
+        if (cand < 0 || i - cand > 65535 || read32(static_cast<size_t>(cand)) != seq) {
+            ++i;
+            continue;
+        }
+        size_t len = MIN_MATCH;
+        while (i + len < n && src[cand + len] == src[i + len]) ++len;
+        size_t lit = i - anchor;
+        size_t extra = len - MIN_MATCH;
+        out.push_back(static_cast<unsigned char>((std::min<size_t>(lit, 15) << 4) | std::min<size_t>(extra, 15)));
+        if (lit >= 15) putLength(lit - 15);
+        out.insert(out.end(), src + anchor, src + i);
+        size_t offset = i - static_cast<size_t>(cand);
+        out.push_back(static_cast<unsigned char>(offset & 0xFF));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if (extra >= 15) putLength(extra - 15);
+        i += len;
+        anchor = i;
+    }
+    size_t lit = n - anchor;
+    out.push_back(static_cast<unsigned char>(std::min<size_t>(lit, 15) << 4));
+    if (lit >= 15) putLength(lit - 15);
+    out.insert(out.end(), src + anchor, src + n);
+    return out;
+}
+
+/**
+ * @brief Decompress a buffer produced by lzCompress
+ * @return false if the input is corrupt or does not expand to exactly dstLen bytes
+ */
+bool lzDecompress(const unsigned char* src, size_t n, unsigned char* dst, size_t dstLen) {
+    size_t ip = 0, op = 0;
+    auto getLength = [&](size_t& len) {
+        unsigned char b;
+        do {
+            if (ip >= n) return false;
+            b = src[ip++];
+            len += b;
+        } while (b == 255);
+        return true;
+    };
+    while (ip < n) {
+        unsigned char token = src[ip++];
+        size_t lit = token >> 4;
+        if (lit == 15 && !getLength(lit)) return false;
+        if (ip + lit > n || op + lit > dstLen) return false;
+        std::copy(src + ip, src + ip + lit, dst + op);
+        ip += lit;
+        op += lit;
+        if (ip >= n) break; // last sequence has no match
+        if (ip + 2 > n) return false;
+        size_t offset = src[ip] | static_cast<size_t>(src[ip + 1]) << 8;
+        ip += 2;
+        size_t len = token & 15;
+        if (len == 15 && !getLength(len)) return false;
+        len += 4;
+        if (offset == 0 || offset > op || op + len > dstLen) return false;
+        for (size_t k = 0; k < len; ++k, ++op) dst[op] = dst[op - offset]; // may overlap
+    }
+    return op == dstLen;
+}
+
+/**
+ * @brief Compressed in-memory swap pool (zswap-style) backed by a size-class arena
+ *
+ * Compressed pages are rounded up to a size class and stored in slots of arena
+ * chunks dedicated to that class. A chunk spans the 1-4 pages that waste the least
+ * space for its class and is released once empty; the pool is limited by the bytes
+ * held in chunks.
+ */
+class CompressedPool {
+    struct Chunk {
+        std::vector<unsigned char> data;
+        std::vector<size_t> freeSlots;
+    };
+    struct SizeClass {
+        size_t slotSize;
+        size_t slotsPerChunk;
+        std::vector<Chunk> chunks; ///< Released chunks have empty data
+    };
+    struct Entry {
+        size_t sizeClass;
+        size_t chunk;
+        size_t slot;
+        size_t length;
+        std::list<uint64_t>::iterator lruPos;
+    };
+    size_t pageSize;
+    size_t granularity;
+    size_t maxBytes;
+    std::vector<SizeClass> classes;
+    std::unordered_map<uint64_t, Entry> entries; // page -> stored entry
+    std::list<uint64_t> lru;                     // most recently stored page at front
+    size_t storedBytes;
+    size_t footprint;
+
+public:
+    enum class StoreResult { Stored, Incompressible, Full };
+
+    size_t stores;
+    size_t rejects;
+    size_t loads;
+    size_t writebacks;
+
+    /**
+     * @brief Constructor
+     * @param pageSz Page size
+     * @param limit Maximum bytes held by arena chunks
+     */
+    CompressedPool(size_t pageSz, size_t limit)
+        : pageSize(pageSz), granularity(std::max<size_t>(8, pageSz / 64)), maxBytes(limit), storedBytes(0), footprint(0),
+          stores(0), rejects(0), loads(0), writebacks(0) {
+        for (size_t sz = granularity; sz < pageSize; sz += granularity) {
+            SizeClass sc;
+            sc.slotSize = sz;
+            size_t bestPages = 1, leastWaste = pageSize % sz;
+            for (size_t pages = 2; pages <= 4; ++pages) {
+                size_t waste = (pages * pageSize) % sz;
+                if (waste * bestPages < leastWaste * pages) {
+                    bestPages = pages;
+                    leastWaste = waste;
+                }
+            }
+            sc.slotsPerChunk = bestPages * pageSize / sz;
+            classes.push_back(sc);
+        }
+    }
+
+    /**
+     * @brief Store a compressed page
+     * @return Incompressible if it is not smaller than a page, Full if it needs a chunk beyond the pool limit
+     */
+    StoreResult store(uint64_t page, const std::vector<unsigned char>& compressed) {
+        erase(page);
+        size_t idx = (compressed.size() + granularity - 1) / granularity;
+        if (idx == 0 || idx > classes.size()) {
+            ++rejects;
+            return StoreResult::Incompressible;
+        }
+        SizeClass& sc = classes[idx - 1];
+        size_t chunkIdx = sc.chunks.size();
+        for (size_t c = 0; c < sc.chunks.size(); ++c) {
+            if (!sc.chunks[c].freeSlots.empty()) {
+                chunkIdx = c;
+                break;
+            }
+        }
+        if (chunkIdx == sc.chunks.size()) {
+            size_t chunkBytes = sc.slotSize * sc.slotsPerChunk;
+            if (footprint + chunkBytes > maxBytes) return StoreResult::Full;
+            for (size_t c = 0; c < sc.chunks.size(); ++c) {
+                if (sc.chunks[c].data.empty()) chunkIdx = c;
+            }
+            if (chunkIdx == sc.chunks.size()) sc.chunks.push_back(Chunk());
+            Chunk& fresh = sc.chunks[chunkIdx];
+            fresh.data.assign(chunkBytes, 0);
+            for (size_t s = sc.slotsPerChunk; s > 0; --s) fresh.freeSlots.push_back(s - 1);
+            footprint += chunkBytes;
+        }
+        Chunk& chunk = sc.chunks[chunkIdx];
+        Entry e;
+        e.sizeClass = idx - 1;
+        e.chunk = chunkIdx;
+        e.slot = chunk.freeSlots.back();
+        e.length = compressed.size();
+        chunk.freeSlots.pop_back();
+        std::copy(compressed.begin(), compressed.end(), chunk.data.begin() + e.slot * sc.slotSize);
+        lru.push_front(page);
+        e.lruPos = lru.begin();
+        entries[page] = e;
+        storedBytes += e.length;
+        ++stores;
+        return StoreResult::Stored;
+    }
+
+    /**
+     * @brief Decompress a stored page into dst and drop it from the pool
+     * @return false if the page is not in the pool
+     */
+    bool load(uint64_t page, unsigned char* dst) {
+        auto it = entries.find(page);
+        if (it == entries.end()) return false;
+        const Entry& e = it->second;
+        const SizeClass& sc = classes[e.sizeClass];
+        lzDecompress(&sc.chunks[e.chunk].data[e.slot * sc.slotSize], e.length, dst, pageSize);
+        erase(page);
+        ++loads;
+        return true;
+    }
+
+    /**
+     * @brief Remove the least recently stored page for writeback
+     * @param page Receives the page number
+     * @param contents Receives the decompressed page
+     * @return false if the pool is empty
+     */
+    bool takeOldest(uint64_t& page, std::vector<unsigned char>& contents) {
+        if (lru.empty()) return false;
+        page = lru.back();
+        const Entry& e = entries[page];
+        const SizeClass& sc = classes[e.sizeClass];
+        contents.assign(pageSize, 0);
+        lzDecompress(&sc.chunks[e.chunk].data[e.slot * sc.slotSize], e.length, contents.data(), pageSize);
+        erase(page);
+        ++writebacks;
+        return true;
+    }
+
+    /**
+     * @brief Drop a page from the pool, releasing its chunk once empty
+     */
+    void erase(uint64_t page) {
+        auto it = entries.find(page);
+        if (it == entries.end()) return;
+        const Entry& e = it->second;
+        SizeClass& sc = classes[e.sizeClass];
+        Chunk& chunk = sc.chunks[e.chunk];
+        chunk.freeSlots.push_back(e.slot);
+        if (chunk.freeSlots.size() == sc.slotsPerChunk) {
+            footprint -= chunk.data.size();
+            std::vector<unsigned char>().swap(chunk.data);
+            chunk.freeSlots.clear();
+        }
+        storedBytes -= e.length;
+        lru.erase(e.lruPos);
+        entries.erase(it);
+    }
+
+    void setLimit(size_t limit) { maxBytes = limit; }
+    bool overLimit() const { return footprint > maxBytes; }
+    size_t limit() const { return maxBytes; }
+    bool contains(uint64_t page) const { return entries.count(page) > 0; }
+    size_t storedPages() const { return entries.size(); }
+    size_t compressedBytes() const { return storedBytes; }
+    size_t arenaBytes() const { return footprint; }
+};
+
+/**
+ * @brief A virtual page: segment index in the high 32 bits, page-table index in the low 32 bits
+ */
+typedef uint64_t PageKey;
+const PageKey NO_PAGE = ~static_cast<PageKey>(0);
+
+inline PageKey pageKey(size_t segIdx, size_t vpn) { return static_cast<PageKey>(segIdx) << 32 | vpn; }
+inline size_t keySegment(PageKey key) { return static_cast<size_t>(key >> 32); }
+inline size_t keyPage(PageKey key) { return static_cast<size_t>(key & 0xFFFFFFFFu); }
+
+/**
+ * @brief Relaxed atomic byte store and load for single-byte accesses to page contents
+ *
+ * Lock-free hits write bytes of a writable frame while other CPUs write the same frame,
+ * or read and write it under the mm lock. Whole-frame copies need no atomics: they only
+ * happen after the frame's writable translations are revoked and a grace period passed.
+ */
+inline void storeByte(unsigned char& byte, unsigned char value) { __atomic_store_n(&byte, value, __ATOMIC_RELAXED); }
+inline unsigned char loadByte(const unsigned char& byte) { return __atomic_load_n(&byte, __ATOMIC_RELAXED); }
+
+/**
+ * @brief A page of a file (page cache key): top bit set, file index in bits 32-62, file page below
+ */
+inline PageKey filePageKey(size_t fileIdx, size_t page) { return static_cast<PageKey>(1) << 63 | static_cast<PageKey>(fileIdx) << 32 | page; }
+inline bool isFilePage(PageKey key) { return (key >> 63) != 0; }
+inline size_t keyFile(PageKey key) { return static_cast<size_t>(key >> 32 & 0x7FFFFFFFu); }
+
+/**
+ * @brief Simulates a Virtual Memory Manager with paging, segmentation, and page replacement
+ */
+class VirtualMemoryManager {
+    size_t pageSize; ///< Base page (and frame) size
+    size_t numFrames;
+    size_t numPages; ///< Base pages in the virtual address space
+    std::vector<Segment> segments;
+    std::vector<PageKey> frameTable; ///< frameTable[frame] = page held (every frame of a huge page), file page, or NO_PAGE
+    ReplacementPolicy policy;
+    // Resident pages by first frame on four replacement lists, most recently added or used at front
+    struct LruPos {
+        LruList list;
+        std::list<size_t>::iterator it;
+        bool referenced; ///< Accessed once since it was added to (or moved to) an inactive list
+    };
+    std::list<size_t> lruLists[5];                     ///< Indexed by LruList
+    std::unordered_map<size_t, LruPos> replacementPos; ///< frame -> its list and position
+    unsigned swappiness;    ///< 0-200: relative preference for reclaiming anonymous over file pages
+    long anonScanCredit;    ///< Weighted round-robin credit of the anonymous lists
+    long fileScanCredit;    ///< Weighted round-robin credit of the file lists
+    size_t activations;
+    size_t deactivations;
+    size_t anonEvictions;
+    size_t fileEvictions;
+    uint64_t workingsetClock; ///< Evictions plus activations (nonresident age)
+    size_t refaults;          ///< Faults on pages with a shadow entry
+    size_t refaultActivations; ///< Refaults within working-set reach, activated at once
+    std::vector<size_t> refaultHistogram; ///< Bucket 0: distance 0, bucket b: distances [2^(b-1), 2^b)
+    size_t cleanFirstWindow; ///< CFLRU: pages at the LRU end of each type searched for a clean victim first
+    size_t cleanFirstPicks;  ///< Victims chosen over an older dirty page
+    size_t pageFaults;
+    std::atomic<size_t> accesses; ///< Advanced without the mm lock by concurrent hits
+    std::atomic<bool> verbose;
+    // Tiered memory
+    TieringConfig tiering;
+    size_t fastFrames;               ///< Frames [0, fastFrames) are fast; equals numFrames when not tiered
+    std::vector<size_t> frameSamples; ///< Sampled accesses per slow-tier frame since it was loaded
+    size_t fastAccesses;
+    size_t slowAccesses;
+    size_t promotions;
+    size_t demotions;
+    size_t swapOuts;
+    double memTimeNs;
+    // Page contents and swap
+    std::vector<unsigned char> physMem; ///< numFrames * pageSize bytes
+    std::unordered_map<PageKey, std::vector<unsigned char>> swapStore; ///< page -> contents on the backing store
+    size_t diskReads;
+    size_t diskWrites;
+    // Compressed swap pool checked before the backing store
+    bool zswapEnabled;
+    CompressedPool zswap;
+    size_t zswapFullRejects;
+    // Same-page merging
+    struct MergedFrame {
+        uint64_t hash;
+        std::vector<PageKey> pages; ///< Pages mapping the shared frame
+    };
+    KsmConfig ksm;
+    std::unordered_map<size_t, MergedFrame> mergedFrames;  ///< shared frame -> its hash and mappers
+    std::unordered_multimap<uint64_t, size_t> stableTree;  ///< content hash -> shared frame
+    std::unordered_map<uint64_t, PageKey> unstableTree;    ///< content hash -> unmerged page seen this pass
+    size_t ksmCursorSeg;
+    size_t ksmCursorPage;
+    size_t ksmScanned;
+    size_t ksmFullScans;
+    size_t ksmMerges;
+    size_t ksmUnmerges;
+    double ksmScanTimeNs;
+    // Address translation
+    PagingConfig paging;
+    ShootdownConfig shootdown;
+    size_t currentCpu;          ///< Core the mm lock is held for: it flushes its own TLB and initiates shootdowns
+    size_t shootdownBatchDepth; ///< Nesting of reclaim passes queueing their shootdowns
+    size_t shootdowns;
+    size_t ipisSent;
+    size_t wastedIpis;          ///< IPIs to cores that cached none of the translations flushed
+    double shootdownWaitNs;     ///< Initiators waiting for acknowledgements
+    double shootdownHandlerNs;  ///< Target cores in flush interrupts
+    static const size_t ASID_SHIFT = 48;
+    static const size_t MAX_ASIDS = 4095; ///< 12-bit tags, as x86 PCIDs
+    size_t asidCount;           ///< ASIDs per core, 0 = untagged TLBs flushed on every context switch
+    size_t contextSwitches;
+    size_t tlbFlushes;          ///< Whole-TLB flushes by switches and rollovers
+    size_t flushedEntries;
+    size_t asidRollovers;
+    size_t keptEntries;         ///< Entries found still cached on switching back to a space
+    size_t switchSavedHits;     ///< Hits on kept entries: page walks flush-on-switch would have made
+    std::unordered_map<size_t, size_t> hostTable; ///< guest frame (or huge group) -> host frame (or huge group)
+    std::list<size_t> hostFifo;                   ///< host mappings in creation order, for host reclaim
+    size_t walkRefs;
+    double walkTimeNs;
+    size_t hostFaults;
+    size_t hostEvictions;
+    size_t guestPteWrites;  ///< Guest page-table updates (shadow sync traps)
+    double trapTimeNs;
+    size_t nestedWalkRefs;  ///< Walk references under nested paging, tracked in either virtualized mode
+    size_t shadowWalkRefs;  ///< Walk references under shadow paging, tracked in either virtualized mode
+    // Segment placement (in base pages of the virtual address space)
+    std::map<size_t, size_t> holes; ///< first free page -> hole length
+    FitPolicy fitPolicy;
+    size_t nextFitPage;             ///< Where the next next-fit search starts
+    size_t segAllocs;
+    size_t segAllocFailures;
+    size_t segFrees;
+    size_t holesScanned;
+    size_t compactions;
+    size_t segmentsMoved;
+    double segAllocTimeNs;
+    // Segment growth
+    size_t growthWindow;   ///< Bytes past the limit that grow a growable segment instead of faulting
+    size_t segGrowths;
+    size_t segGrowthPages;
+    size_t segGrowthFailures;
+    double growthTimeNs;   ///< Page-table population cost of growth
+    // File-backed mappings and the page cache
+    struct SimFile {
+        std::string name;
+        std::unordered_map<size_t, std::vector<unsigned char>> pages; ///< file page -> contents written back
+        std::unordered_map<size_t, uint64_t> shadows;                 ///< file page -> workingset clock at eviction
+    };
+    struct CachedPage {
+        PageKey filePage;
+        std::vector<PageKey> mappers; ///< Segment pages mapping the cached page
+        bool dirty;                   ///< Written through a mapping that is gone; needs writeback
+        bool readAhead;               ///< Read by readahead and not faulted on since
+        CachedPage() : filePage(NO_PAGE), dirty(false), readAhead(false) {}
+    };
+    std::vector<SimFile> files;
+    std::unordered_map<PageKey, size_t> pageCache;       ///< file page -> frame
+    std::unordered_map<size_t, CachedPage> cachedFrames; ///< frame -> cached file page
+    size_t majorFaults;
+    size_t fileReads;
+    size_t fileWrites;
+    // Readahead and madvise hints
+    size_t readaheadWindow; ///< File pages read after a major fault on a normally advised segment
+    size_t readaheadPages;
+    size_t readaheadHits;   ///< Faults that found a read-ahead page cached
+    size_t prefetchedPages; ///< Pages loaded by WILLNEED
+    size_t prefetchHits;    ///< Accesses that found a WILLNEED page still loaded
+    size_t droppedPages;    ///< Resident pages dropped by DONTNEED
+    size_t coldPages;       ///< Pages moved to an inactive list by COLD
+    // Pinning
+    size_t lockedPages;     ///< Pages locked by mlock
+    size_t outOfMemory;     ///< Faults that failed because every resident page was pinned
+    // Watermark reclaim
+    ReclaimConfig reclaim;
+    bool kswapdAwake;
+    size_t kswapdWakeups;
+    size_t kswapdPages;     ///< Pages demoted or swapped out by kswapd
+    size_t reclaimInvocations;
+    size_t ioSubmissions;   ///< Grouped writeback I/Os of reclaim invocations
+    size_t reclaimWrites;   ///< Pages written back by reclaim invocations
+    double ioWriteTimeNs;   ///< Writeback I/O time of reclaim, the flusher and throttled writers
+    double kswapdTimeNs;    ///< Background reclaim time, not charged to accesses
+    size_t directStalls;    ///< Allocations that had to reclaim synchronously
+    size_t directPages;     ///< Pages demoted or swapped out by direct reclaim
+    double stallTimeNs;     ///< Direct reclaim time, charged to the faulting accesses
+    double maxStallNs;
+    // Dirty writeback
+    WritebackConfig writeback;
+    std::unordered_map<PageKey, size_t> dirtySince; ///< dirty anonymous page or file page -> access count when dirtied
+    size_t flusherWakeups;
+    size_t flushedExpired;  ///< Pages the flusher wrote back for their age
+    size_t flushedBackground; ///< Pages the flusher wrote back for the background ratio
+    double flusherTimeNs;   ///< Background writeback time, not charged to accesses
+    size_t throttledWrites;
+    size_t throttledPages;  ///< Pages written back by throttled writers
+    double throttleTimeNs;  ///< Time writers spent throttled, charged to them
+    // Region-based access monitoring
+    struct DamonRegion {
+        size_t seg;
+        size_t start;      ///< First page-table index
+        size_t end;        ///< One past the last page-table index
+        size_t sample;     ///< Page whose accessed bit was cleared at the last sample
+        size_t nrAccesses; ///< Samples that found the region accessed in the current aggregation
+        size_t lastNrAccesses; ///< nrAccesses of the previous aggregation
+        size_t age;        ///< Aggregations with a similar access count
+    };
+    DamonConfig damon;
+    std::vector<DamonRegion> damonRegions; ///< Sorted by segment and start; each in-use segment covered
+    uint64_t damonRng;
+    size_t damonSamples;
+    size_t damonChecks;    ///< Accessed bits checked (the monitoring cost)
+    size_t damonAggregations;
+    size_t damonPageouts;  ///< Resident pages reclaimed from cold regions
+    // Idle-page tracking and proactive reclaim
+    IdleReclaimConfig idleReclaim;
+    std::vector<bool> accessBitmap;         ///< Idle-page bitmap: bit per frame set on access, cleared by every idle scan
+    std::vector<size_t> idleAge;            ///< Idle scans in a row that found the frame's bit clear
+    std::unordered_set<PageKey> idleEvicted; ///< Pages reclaimed as idle and not faulted back yet (file pages by file page key)
+    size_t idleScanRuns;
+    size_t idleReclaimed;
+    size_t idleRefaults;                    ///< Faults on pages reclaimed as idle
+    // Flat virtual address lookup
+    std::map<size_t, size_t> segmentIndex; ///< base address -> in-use segment
+    size_t lastHitSeg;                     ///< Segment found by the previous lookup
+    size_t vaLookups;
+    size_t vaCacheHits;
+    // Concurrency: faults and every structural change hold the mm lock. A hit on a resident page
+    // takes no lock at all: it reads a published copy of the page tables inside an epoch read section
+    static const size_t HIT_BATCH = 32;      ///< Fast-path hits a CPU batches before applying them
+    static const size_t MAX_RETIRED = 8;     ///< Retired layouts kept before a grace period is forced
+    struct HitRecord {
+        size_t seg;
+        size_t vpn;
+        size_t frame;
+        size_t basePage; ///< Base page within a huge page, for the TLB entry
+    };
+    struct CpuState {
+        size_t id;
+        Tlb tlb;                           ///< The core's own TLB; like the batch, only touched under the mm lock
+        size_t space;                      ///< Address space the core runs
+        size_t asid;                       ///< Tag of the running space's TLB entries (0 when untagged)
+        uint64_t asidGeneration;           ///< Bumped when the core's ASID pool rolls over
+        size_t nextAsid;
+        std::unordered_map<size_t, std::pair<uint64_t, size_t>> spaceAsids; ///< space -> (generation, ASID) on this core
+        std::unordered_set<size_t> spacesCached; ///< Spaces whose translations the TLB may hold (their shootdown cpumasks)
+        std::unordered_set<uint64_t> carried;    ///< Entries of the running space kept across the last switch
+        bool ipiPending;                   ///< Queued for a shootdown IPI
+        bool ipiNeeded;                    ///< A queued flush hit a translation the core actually cached
+        size_t ipisReceived;
+        std::vector<HitRecord> batch;      ///< Hits whose TLB, list, bitmap and statistics updates are pending (owner only)
+        std::atomic<uint64_t> readerEpoch; ///< Global epoch announced on entering a read section, 0 outside one
+        size_t lastHitSeg;                 ///< Segment found by the CPU's previous lock-free address lookup
+        std::atomic<size_t> fastHits;
+        std::atomic<size_t> vaLookups;
+        std::atomic<size_t> vaCacheHits;
+        CpuState(size_t core, size_t tlbEntries)
+            : id(core), tlb(tlbEntries), space(0), asid(0), asidGeneration(0), nextAsid(1), ipiPending(false), ipiNeeded(false), ipisReceived(0), readerEpoch(0),
+              lastHitSeg(0), fastHits(0), vaLookups(0), vaCacheHits(0) {}
+    };
+    /**
+     * @brief Published copy of a segment's page table: a word per page, 0 until the slow path publishes it
+     *
+     * A published word is frame << 2 | writable << 1 | 1; writable means a store needs no
+     * dirty tracking (the page is already dirty, private, anonymous and queued for writeback).
+     */
+    struct HitTable {
+        bool inUse;
+        size_t base;
+        size_t top; ///< One past the last byte of the segment's address range
+        size_t limit;
+        size_t pageBytes;
+        bool growsDown;
+        size_t pages;
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+        HitTable() : inUse(false), base(0), top(0), limit(0), pageBytes(1), growsDown(false), pages(0) {}
+    };
+    /**
+     * @brief Layout readers see: replaced whole, never edited, when segments change, and freed
+     * only after every read section that could have loaded it has ended
+     */
+    struct HitDirectory {
+        std::vector<HitTable> tables;
+        std::vector<std::pair<size_t, size_t>> index; ///< (base, segment) of in-use segments, by base
+    };
+    std::vector<std::unique_ptr<CpuState>> cpus; ///< One per simulated CPU, each driven by one thread
+    std::atomic<HitDirectory*> hitDirectory;     ///< Null with a single CPU
+    std::vector<HitDirectory*> retiredDirectories;
+    std::atomic<uint64_t> globalEpoch;
+    bool graceNeeded;     ///< A published word was revoked or a layout retired since the last grace period
+    size_t gracePeriods;
+    size_t revocations;   ///< Published words revoked before their page or frame changed
+    size_t batchDrains;
+    mutable std::atomic<size_t> backgroundDueAt; ///< Access count at which hits must take the slow path for background work
+    mutable std::mutex mmLock;
+    mutable std::atomic<std::thread::id> exclusiveOwner;
+
+    /**
+     * @brief Exclusive hold of the address space: the mm lock, nesting within a thread
+     *
+     * Releasing it reschedules when lock-free hits next have to yield to background work.
+     */
+    class ExclusiveGuard {
+        const VirtualMemoryManager& vmm;
+        bool outer;
+        bool held;
+
+    public:
+        /**
+         * @param tryOnly Give up instead of waiting if another thread holds the lock (see owns)
+         */
+        explicit ExclusiveGuard(const VirtualMemoryManager& m, bool tryOnly = false) : vmm(m), outer(!m.holdsExclusive()), held(true) {
+            if (!outer) return;
+            if (!tryOnly) vmm.mmLock.lock();
+            else if (!vmm.mmLock.try_lock()) outer = held = false;
+            if (outer) vmm.exclusiveOwner.store(std::this_thread::get_id());
+        }
+        ~ExclusiveGuard() {
+            if (!outer) return;
+            vmm.scheduleBackgroundWork();
+            vmm.exclusiveOwner.store(std::thread::id());
+            vmm.mmLock.unlock();
+        }
+        bool owns() const { return held; }
+    };
+
+    /**
+     * @brief Epoch read section of a CPU: while it lasts, nothing it loads from the published tables is freed or reused
+     */
+    class ReadSection {
+        CpuState& state;
+
+    public:
+        ReadSection(CpuState& s, const std::atomic<uint64_t>& epoch) : state(s) { state.readerEpoch.store(epoch.load()); }
+        ~ReadSection() { state.readerEpoch.store(0); }
+    };
+
+    bool holdsExclusive() const { return exclusiveOwner.load() == std::this_thread::get_id(); }
+
+public:
+    /**
+     * @brief Constructor
+     * @param memSize Total (virtual) memory size
+     * @param pageSz Page size
+     * @param segNames Names of segments
+     * @param pol Page replacement policy
+     * @param physMemSize Physical memory size (0 = same as memSize)
+     * @param tierCfg Tiered memory settings
+     */
+    explicit VirtualMemoryManager(size_t memSize, size_t pageSz, const std::vector<std::string>& segNames, ReplacementPolicy pol,
+                                  size_t physMemSize = 0, const TieringConfig& tierCfg = TieringConfig())
+        : pageSize(pageSz), policy(pol), swappiness(60), anonScanCredit(0), fileScanCredit(0), activations(0),
+          deactivations(0), anonEvictions(0), fileEvictions(0), workingsetClock(0),
+          refaults(0), refaultActivations(0), cleanFirstPicks(0), pageFaults(0), accesses(0), verbose(true), tiering(tierCfg),
+          fastAccesses(0), slowAccesses(0), promotions(0), demotions(0), swapOuts(0), memTimeNs(0.0),
+          diskReads(0), diskWrites(0), zswapEnabled(false), zswap(pageSz, 0), zswapFullRejects(0),
+          ksmCursorSeg(0), ksmCursorPage(0), ksmScanned(0), ksmFullScans(0), ksmMerges(0), ksmUnmerges(0), ksmScanTimeNs(0.0),
+          currentCpu(0), shootdownBatchDepth(0), shootdowns(0), ipisSent(0), wastedIpis(0), shootdownWaitNs(0.0),
+          shootdownHandlerNs(0.0), asidCount(0), contextSwitches(0), tlbFlushes(0), flushedEntries(0), asidRollovers(0),
+          keptEntries(0), switchSavedHits(0), walkRefs(0), walkTimeNs(0.0), hostFaults(0), hostEvictions(0),
+          guestPteWrites(0), trapTimeNs(0.0), nestedWalkRefs(0), shadowWalkRefs(0),
+          fitPolicy(FitPolicy::FirstFit), nextFitPage(0), segAllocs(0), segAllocFailures(0), segFrees(0),
+          holesScanned(0), compactions(0), segmentsMoved(0), segAllocTimeNs(0.0),
+          growthWindow(4 * pageSz), segGrowths(0), segGrowthPages(0), segGrowthFailures(0), growthTimeNs(0.0),
+          majorFaults(0), fileReads(0), fileWrites(0), readaheadWindow(4), readaheadPages(0), readaheadHits(0),
+          prefetchedPages(0), prefetchHits(0), droppedPages(0), coldPages(0), lockedPages(0), outOfMemory(0), kswapdAwake(false),
+          kswapdWakeups(0), kswapdPages(0), reclaimInvocations(0), ioSubmissions(0), reclaimWrites(0), ioWriteTimeNs(0.0), kswapdTimeNs(0.0), directStalls(0), directPages(0), stallTimeNs(0.0), maxStallNs(0.0),
+          flusherWakeups(0), flushedExpired(0), flushedBackground(0), flusherTimeNs(0.0), throttledWrites(0), throttledPages(0),
+          throttleTimeNs(0.0), damonRng(88172645463325252ull), damonSamples(0), damonChecks(0), damonAggregations(0), damonPageouts(0),
+          idleScanRuns(0), idleReclaimed(0), idleRefaults(0),
+          lastHitSeg(0), vaLookups(0), vaCacheHits(0), hitDirectory(nullptr), globalEpoch(1), graceNeeded(false),
+          gracePeriods(0), revocations(0), batchDrains(0), backgroundDueAt(0) {
+        numFrames = (physMemSize ? physMemSize : memSize) / pageSize;
+        cleanFirstWindow = std::max<size_t>(1, numFrames / 4);
+        physMem.assign(numFrames * pageSize, 0);
+        numPages = memSize / pageSize;
+        frameTable.assign(numFrames, NO_PAGE);
+        frameSamples.assign(numFrames, 0);
+        accessBitmap.assign(numFrames, false);
+        idleAge.assign(numFrames, 0);
+        fastFrames = (tiering.fastFrames > 0 && tiering.fastFrames < numFrames) ? tiering.fastFrames : numFrames;
+        if (tiering.sampleInterval == 0) tiering.sampleInterval = 1;
+        // Create page-aligned segments of equal size; leftover pages form a hole
+        size_t nSegments = segNames.size();
+        size_t segPages = numPages / nSegments;
+        for (size_t i = 0; i < nSegments; ++i) {
+            segments.emplace_back(segNames[i], i * segPages * pageSize, segPages * pageSize, segPages);
+            segmentIndex[i * segPages * pageSize] = i;
+        }
+        if (nSegments * segPages < numPages) holes[nSegments * segPages] = numPages - nSegments * segPages;
+        cpus.emplace_back(new CpuState(0, paging.tlbEntries));
+    }
+
+    ~VirtualMemoryManager() {
+        delete hitDirectory.load();
+        for (HitDirectory* dir : retiredDirectories) delete dir;
+    }
+
+    /**
+     * @brief Display all segments
+     */
+    void showSegments() const {
+        ExclusiveGuard guard(*this);
+        std::cout << "\nSegments:\n";
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const auto& seg = segments[i];
+            if (!seg.inUse) continue;
+            std::cout << i << ": " << seg.name << ": Base = " << seg.base << ", Limit = " << seg.limit;
+            if (seg.pageFrames > 1) std::cout << ", Page size = " << pageBytes(seg);
+            if (seg.space != 0) std::cout << ", Address space = " << seg.space;
+            if (seg.growth != SegmentGrowth::None) std::cout << (seg.growth == SegmentGrowth::Up ? " (grows up)" : " (grows down)");
+            std::cout << '\n';
+        }
+    }
+
+    /**
+     * @brief Display the page table of every segment
+     */
+    void showPageTable() const {
+        ExclusiveGuard guard(*this);
+        std::cout << "\nPage Tables (Page -> Frame):\n";
+        for (size_t s = 0; s < segments.size(); ++s) {
+            const Segment& seg = segments[s];
+            if (!seg.inUse) continue;
+            std::cout << "Segment " << s << " (" << seg.name << ", " << pageBytes(seg) << "-byte pages):\n";
+            for (size_t i = 0; i < seg.pageTable.size(); ++i) {
+                const PageTableEntry& pte = seg.pageTable[i];
+                if (pte.valid)
+                    std::cout << "  Page " << i << " -> Frame " << pte.frameNumber << (pte.merged ? " (merged)" : "") << (pte.locked ? " (locked)" : "") << '\n';
+                else
+                    std::cout << "  Page " << i << " -> Not in memory\n";
+            }
+        }
+    }
+
+    /**
+     * @brief Display the frame table
+     */
+    void showFrames() const {
+        ExclusiveGuard guard(*this);
+        std::cout << "\nFrames (Frame -> Segment:Page):\n";
+        for (size_t i = 0; i < frameTable.size(); ++i) {
+            std::cout << "Frame " << i;
+            if (isTiered()) std::cout << (i < fastFrames ? " [fast]" : " [slow]");
+            auto merged = mergedFrames.find(i);
+            if (merged != mergedFrames.end()) {
+                std::cout << " -> Pages";
+                for (PageKey page : merged->second.pages) std::cout << ' ' << pageName(page);
+                std::cout << " (merged)\n";
+            } else if (cachedFrames.count(i)) {
+                PageKey page = frameTable[i];
+                std::cout << " -> File " << files[keyFile(page)].name << " page " << keyPage(page);
+                const CachedPage& cached = cachedFrames.find(i)->second;
+                if (cached.mappers.empty()) std::cout << " (cached, not mapped)";
+                else std::cout << ", mapped by";
+                for (PageKey mapper : cached.mappers) std::cout << ' ' << pageName(mapper);
+                std::cout << '\n';
+            } else if (frameTable[i] != NO_PAGE) {
+                PageKey page = frameTable[i];
+                std::cout << " -> Page " << pageName(page);
+                if (static_cast<size_t>(pte(page).frameNumber) != i) std::cout << " (continued)";
+                std::cout << '\n';
+            } else {
+                std::cout << " -> Empty\n";
+            }
+        }
+    }
+
+    /**
+     * @brief Access a logical address (segment + offset)
+     * @param segIdx Segment index
+     * @param offset Offset within segment
+     * @param write Store value at the address instead of reading it
+     * @param value Byte to store on a write
+     * @param cpu Simulated CPU making the access (see setCpus)
+     * @return false if the address is invalid
+     */
+    bool accessAddress(size_t segIdx, size_t offset, bool write = false, unsigned char value = 0, size_t cpu = 0) {
+        if (cpus.size() > 1 && accessHit(segIdx, offset, write, value, cpu)) return true;
+        ExclusiveGuard guard(*this);
+        if (cpu < cpus.size()) drainHitBatch(*cpus[cpu]);
+        currentCpu = cpu < cpus.size() ? cpu : 0;
+        if (segIdx >= segments.size() || !segments[segIdx].inUse) {
+            if (verbose) std::cout << "Invalid segment index!\n";
+            return false;
+        }
+        Segment& seg = segments[segIdx];
+        if (offset >= seg.limit) {
+            if (!growOnAccess(segIdx, offset)) {
+                if (verbose) std::cout << "Offset out of bounds!\n";
+                return false;
+            }
+            if (verbose) std::cout << "Segment " << segIdx << " grew to " << seg.limit << " bytes.\n";
+        }
+        size_t bytes = pageBytes(seg);
+        size_t vpn = offset / bytes;
+        size_t pageOffset = seg.growth == SegmentGrowth::Down ? bytes - 1 - offset % bytes : offset % bytes;
+        size_t logicalAddr = linearAddress(seg, offset);
+        PageKey page = pageKey(segIdx, vpn);
+        kswapdRun(); // background reclaim since the previous access
+        if (damon.sampleInterval > 0 && accesses > 0 && accesses % damon.sampleInterval == 0) damonSample();
+        if (idleReclaim.scanInterval > 0 && accesses > 0 && accesses % idleReclaim.scanInterval == 0) idleScan();
+        ++accesses;
+        ++seg.accesses;
+        CpuState& core = *cpus[currentCpu];
+        uint64_t tlbEntry;
+        bool tlbHit = coreTlbLookup(core, segIdx, vpn * seg.pageFrames + pageOffset / pageSize, tlbEntry);
+        if (!tlbHit) {
+            ++seg.tlbMisses;
+            pageWalk(seg.pageFrames);
+        }
+        if (!seg.pageTable[vpn].valid) {
+            ++pageFaults;
+            ++seg.faults;
+            FaultResult fault = handlePageFault(page);
+            if (fault == FaultResult::OutOfMemory) {
+                ++outOfMemory;
+                if (verbose) std::cout << "Out of memory: every resident page is pinned!\n";
+                return false;
+            }
+            bool major = fault == FaultResult::Major;
+            if (major) {
+                ++majorFaults;
+                ++seg.majorFaults;
+            }
+            if (verbose)
+                std::cout << (major ? "Major" : "Minor") << " page fault occurred! Loaded page " << pageName(page) << " into memory.\n";
+        }
+        seg.pageTable[vpn].accessed = true;
+        if (seg.pageTable[vpn].prefetched) {
+            ++prefetchHits;
+            seg.pageTable[vpn].prefetched = false;
+        }
+        if (write && seg.pageTable[vpn].merged) breakCow(page);
+        size_t frameNum = static_cast<size_t>(seg.pageTable[vpn].frameNumber);
+        if (!tlbHit) {
+            if (isVirtualized()) translateHost(frameNum + pageOffset / pageSize);
+            coreTlbFill(core, segIdx, tlbEntry);
+        }
+        if (policy != ReplacementPolicy::FIFO) markAccessed(frameNum);
+        size_t physicalAddr = frameNum * pageSize + pageOffset;
+        if (write) {
+            storeByte(physMem[physicalAddr], value);
+            seg.pageTable[vpn].dirty = true;
+            noteDirty(page);
+        }
+        if (verbose) {
+            std::cout << "Logical Address: " << logicalAddr << " (Segment " << segIdx << ", Offset " << offset << ")\n";
+            std::cout << "Physical Address: " << physicalAddr << " (Frame " << frameNum << ", Offset " << pageOffset << ")\n";
+            std::cout << (write ? "Wrote " : "Read ") << static_cast<int>(loadByte(physMem[physicalAddr])) << '\n';
+        }
+        accessBitmap[frameNum] = true;
+        recordTierAccess(frameNum);
+        if (ksm.pagesToScan > 0 && accesses % ksm.scanInterval == 0) ksmScan();
+        if (writeback.interval > 0 && accesses % writeback.interval == 0) flushDirty();
+        publish(segIdx, vpn);
+        return true;
+    }
+
+    /**
+     * @brief Concurrent fast path: complete a hit on a resident page without taking any lock
+     *
+     * The lookup is wait-free: inside an epoch read section it loads the published layout
+     * and the page's word, and a frame found there stays the page's until the section ends.
+     * Returns false, having changed nothing, for whatever needs the slow path: a fault,
+     * growth, an unpublished page, the first write to a clean, shared or file page, or
+     * background work falling due with this access. Like Linux's per-CPU LRU batches, the
+     * TLB, replacement-list, accessed-bit and tier updates of a hit are queued on its CPU
+     * and applied under the mm lock, when that is free or the batch grows too long.
+     */
+    bool accessHit(size_t segIdx, size_t offset, bool write, unsigned char value, size_t cpu) {
+        if (cpu >= cpus.size() || verbose || holdsExclusive()) return false;
+        CpuState& state = *cpus[cpu];
+        {
+            ReadSection section(state, globalEpoch);
+            const HitDirectory* dir = hitDirectory.load();
+            if (!dir || segIdx >= dir->tables.size()) return false;
+            const HitTable& table = dir->tables[segIdx];
+            if (!table.inUse || offset >= table.limit) return false;
+            size_t vpn = offset / table.pageBytes;
+            size_t pageOffset = table.growsDown ? table.pageBytes - 1 - offset % table.pageBytes : offset % table.pageBytes;
+            uint64_t word = table.words[vpn].load();
+            if (!(word & 1) || (write && !(word & 2))) return false;
+            size_t n = accesses.load();
+            do {
+                if (n >= backgroundDueAt.load()) return false;
+            } while (!accesses.compare_exchange_weak(n, n + 1));
+            size_t frame = static_cast<size_t>(word >> 2);
+            if (write) storeByte(physMem[frame * pageSize + pageOffset], value);
+            HitRecord hit = {segIdx, vpn, frame, pageOffset / pageSize};
+            state.batch.push_back(hit);
+        }
+        ++state.fastHits;
+        if (state.batch.size() >= HIT_BATCH) {
+            ExclusiveGuard guard(*this, state.batch.size() < 4 * HIT_BATCH);
+            if (guard.owns()) drainHitBatch(state);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Record the access count at which hits next have to take the slow path, which alone runs background work
+     */
+    void scheduleBackgroundWork() const {
+        size_t n = accesses.load();
+        size_t due = std::numeric_limits<size_t>::max();
+        // First count m >= n with (m + shift) % interval == 0; sampling and scans skip count 0
+        auto next = [n](size_t interval, size_t shift) {
+            size_t from = std::max<size_t>(n, shift ? 0 : 1);
+            return (from + shift + interval - 1) / interval * interval - shift;
+        };
+        if (kswapdAwake) due = n;
+        if (damon.sampleInterval > 0) due = std::min(due, next(damon.sampleInterval, 0));
+        if (idleReclaim.scanInterval > 0) due = std::min(due, next(idleReclaim.scanInterval, 0));
+        if (ksm.pagesToScan > 0) due = std::min(due, next(ksm.scanInterval, 1));
+        if (writeback.interval > 0) due = std::min(due, next(writeback.interval, 1));
+        backgroundDueAt.store(due);
+    }
+
+    /**
+     * @brief Apply a CPU's batched fast-path hits; a hit whose page was evicted or moved since only counts
+     *
+     * Called with the address space held exclusively, by the CPU's own thread or while no accessor runs.
+     */
+    void drainHitBatch(CpuState& state) {
+        if (state.batch.empty()) return;
+        ++batchDrains;
+        currentCpu = state.id;
+        for (const HitRecord& hit : state.batch) {
+            if (hit.seg >= segments.size() || !segments[hit.seg].inUse) continue;
+            Segment& seg = segments[hit.seg];
+            ++seg.accesses;
+            if (hit.vpn >= seg.pageTable.size()) continue;
+            PageTableEntry& entry = seg.pageTable[hit.vpn];
+            if (!entry.valid || static_cast<size_t>(entry.frameNumber) != hit.frame) continue;
+            uint64_t tlbEntry;
+            if (!coreTlbLookup(state, hit.seg, hit.vpn * seg.pageFrames + hit.basePage, tlbEntry)) {
+                ++seg.tlbMisses;
+                pageWalk(seg.pageFrames);
+                if (isVirtualized()) translateHost(hit.frame + hit.basePage);
+                coreTlbFill(state, hit.seg, tlbEntry);
+            }
+            entry.accessed = true;
+            accessBitmap[hit.frame] = true;
+            if (policy != ReplacementPolicy::FIFO) markAccessed(hit.frame);
+            recordTierAccess(hit.frame);
+        }
+        state.batch.clear();
+    }
+
+    /**
+     * @brief Publish a page's current translation for lock-free hits (after a slow-path access)
+     */
+    void publish(size_t segIdx, size_t vpn) {
+        HitDirectory* dir = hitDirectory.load();
+        if (!dir || segIdx >= dir->tables.size() || vpn >= dir->tables[segIdx].pages) return;
+        const Segment& seg = segments[segIdx];
+        const PageTableEntry& entry = seg.pageTable[vpn];
+        uint64_t word = 0;
+        if (entry.valid && !entry.prefetched) {
+            bool writable = entry.dirty && !entry.merged && seg.file < 0 &&
+                            (writeback.interval == 0 || dirtySince.count(dirtyKey(pageKey(segIdx, vpn))));
+            word = static_cast<uint64_t>(entry.frameNumber) << 2 | (writable ? 2 : 0) | 1;
+        }
+        uint64_t old = dir->tables[segIdx].words[vpn].exchange(word);
+        if (old != 0 && old != word) {
+            ++revocations;
+            graceNeeded = true;
+        }
+    }
+
+    /**
+     * @brief Withdraw a page's published translation; readers may still hold it until the next grace period
+     */
+    void unpublish(PageKey page, bool writableOnly = false) {
+        HitDirectory* dir = hitDirectory.load();
+        size_t segIdx = keySegment(page), vpn = keyPage(page);
+        if (!dir || segIdx >= dir->tables.size() || vpn >= dir->tables[segIdx].pages) return;
+        std::atomic<uint64_t>& word = dir->tables[segIdx].words[vpn];
+        if (writableOnly && !(word.load() & 2)) return;
+        if (word.exchange(0) != 0) {
+            ++revocations;
+            graceNeeded = true;
+        }
+    }
+
+    /**
+     * @brief Make a frame private to the mm lock before its contents are copied or it is reused
+     *
+     * Withdraws the translations of every mapper, then waits out the readers that may
+     * have loaded one of them (or any other revoked word or retired layout).
+     * @param writableOnly Only stop stores, before contents are read in place
+     */
+    void revokeFrame(size_t frame, bool writableOnly = false) {
+        if (!hitDirectory.load()) return;
+        for (PageKey page : mappersOf(frame)) unpublish(page, writableOnly);
+        if (graceNeeded) synchronizeReaders();
+    }
+
+    /**
+     * @brief Grace period: advance the global epoch and wait for every read section entered before it to end
+     *
+     * Read sections never block, so the wait is short; retired layouts are freed after it.
+     */
+    void synchronizeReaders() {
+        uint64_t epoch = globalEpoch.fetch_add(1);
+        for (const std::unique_ptr<CpuState>& state : cpus) {
+            while (true) {
+                uint64_t seen = state->readerEpoch.load();
+                if (seen == 0 || seen > epoch) break;
+                std::this_thread::yield();
+            }
+        }
+        for (HitDirectory* dir : retiredDirectories) delete dir;
+        retiredDirectories.clear();
+        graceNeeded = false;
+        ++gracePeriods;
+    }
+
+    /**
+     * @brief Publish a fresh, empty layout after segments change (or none with a single CPU) and retire the old one
+     */
+    void rebuildHitTables() {
+        HitDirectory* dir = nullptr;
+        if (cpus.size() > 1) {
+            dir = new HitDirectory();
+            dir->tables.resize(segments.size());
+            for (size_t s = 0; s < segments.size(); ++s) {
+                const Segment& seg = segments[s];
+                HitTable& table = dir->tables[s];
+                if (!seg.inUse) continue;
+                table.inUse = true;
+                table.base = seg.base;
+                table.top = seg.base + segmentPages(seg) * pageSize;
+                table.limit = seg.limit;
+                table.pageBytes = pageBytes(seg);
+                table.growsDown = seg.growth == SegmentGrowth::Down;
+                table.pages = seg.pageTable.size();
+                table.words.reset(new std::atomic<uint64_t>[table.pages]);
+                for (size_t vpn = 0; vpn < table.pages; ++vpn) table.words[vpn].store(0);
+                dir->index.push_back(std::make_pair(seg.base, s));
+            }
+            std::sort(dir->index.begin(), dir->index.end());
+        }
+        HitDirectory* old = hitDirectory.exchange(dir);
+        if (old) {
+            retiredDirectories.push_back(old);
+            graceNeeded = true;
+        }
+        if (retiredDirectories.size() >= MAX_RETIRED) synchronizeReaders();
+    }
+
+    /**
+     * @brief Set the number of simulated CPUs; each may call accessAddress and accessVirtual from its own thread
+     *
+     * With more than one CPU, hits on resident pages take the lock-free fast path.
+     * No accessor may be running.
+     */
+    void setCpus(size_t count) {
+        ExclusiveGuard guard(*this);
+        for (std::unique_ptr<CpuState>& state : cpus) drainHitBatch(*state);
+        cpus.clear();
+        for (size_t i = 0; i < std::max<size_t>(1, count); ++i) {
+            cpus.emplace_back(new CpuState(i, paging.tlbEntries));
+            resetAsids(*cpus.back());
+        }
+        currentCpu = 0;
+        rebuildHitTables();
+    }
+
+    size_t getCpus() const { return cpus.size(); }
+
+    /**
+     * @brief Headline counters for batch reports
+     */
+    ReplaySummary summary() const {
+        ExclusiveGuard guard(*this);
+        ReplaySummary result;
+        result.accesses = accesses;
+        result.pageFaults = pageFaults;
+        result.majorFaults = majorFaults;
+        result.evictions = anonEvictions + fileEvictions;
+        for (const std::unique_ptr<CpuState>& state : cpus) {
+            result.tlbHits += state->tlb.hits;
+            result.tlbMisses += state->tlb.misses;
+        }
+        result.simNs = simTimeNs();
+        return result;
+    }
+
+    /**
+     * @brief Apply every CPU's pending fast-path hits, e.g. before reading statistics after a concurrent run
+     *
+     * No accessor may be running.
+     */
+    void quiesce() {
+        ExclusiveGuard guard(*this);
+        for (std::unique_ptr<CpuState>& state : cpus) drainHitBatch(*state);
+    }
+
+    PageTableEntry& pte(PageKey page) { return segments[keySegment(page)].pageTable[keyPage(page)]; }
+    const PageTableEntry& pte(PageKey page) const { return segments[keySegment(page)].pageTable[keyPage(page)]; }
+
+    std::string pageName(PageKey page) const { return std::to_string(keySegment(page)) + ":" + std::to_string(keyPage(page)); }
+
+    size_t pageBytes(const Segment& seg) const { return seg.pageFrames * pageSize; }
+
+    /**
+     * @brief Frames held by the page in a frame: its segment's page size
+     */
+    size_t spanOf(size_t frame) const {
+        return isFilePage(frameTable[frame]) ? 1 : segments[keySegment(frameTable[frame])].pageFrames;
+    }
+
+    /**
+     * @brief Base pages covered by one TLB entry for pages of the given size
+     *
+     * Under virtualization an entry is limited to the host mapping size.
+     */
+    size_t tlbSpan(size_t pageFrames) const {
+        if (!isVirtualized()) return pageFrames;
+        return paging.hostHugePages ? std::min(pageFrames, paging.hugePageFactor) : 1;
+    }
+
+    /**
+     * @brief TLB key of a base page of a segment (counted in page-table order)
+     */
+    uint64_t tlbKey(size_t segIdx, size_t basePage) const {
+        return pageKey(segIdx, basePage / tlbSpan(segments[segIdx].pageFrames));
+    }
+
+    size_t guestWalkLevels(size_t pageFrames) const {
+        return paging.guestLevels - (pageFrames > 1 && paging.guestLevels > 1 ? 1 : 0);
+    }
+    size_t hostWalkLevels() const { return paging.hostLevels - (paging.hostHugePages && paging.hostLevels > 1 ? 1 : 0); }
+
+    size_t nestedWalkLength(size_t pageFrames) const { return (guestWalkLevels(pageFrames) + 1) * (hostWalkLevels() + 1) - 1; }
+    size_t shadowWalkLength(size_t pageFrames) const {
+        return paging.guestLevels - (pageFrames > 1 && paging.hostHugePages && paging.guestLevels > 1 ? 1 : 0);
+    }
+    bool isVirtualized() const { return paging.mode != VirtMode::Native; }
+
+    /**
+     * @brief Memory references of one TLB-miss walk in the current mode, for pages of the given size
+     */
+    size_t walkLength(size_t pageFrames) const {
+        switch (paging.mode) {
+            case VirtMode::Nested: return nestedWalkLength(pageFrames);
+            case VirtMode::Shadow: return shadowWalkLength(pageFrames);
+            default: return guestWalkLevels(pageFrames);
+        }
+    }
+
+    /**
+     * @brief Charge the page walk of a TLB miss
+     *
+     * Under virtualization the walk lengths of both nested and shadow paging are
+     * recorded so the two modes can be compared on one run.
+     */
+    void pageWalk(size_t pageFrames) {
+        size_t refs = walkLength(pageFrames);
+        walkRefs += refs;
+        walkTimeNs += refs * paging.walkRefNs;
+        if (isVirtualized()) {
+            nestedWalkRefs += nestedWalkLength(pageFrames);
+            shadowWalkRefs += shadowWalkLength(pageFrames);
+        }
+    }
+
+    /**
+     * @brief A page's (guest) page-table entry changed: drop its cached and published translations
+     *
+     * Under shadow paging the write traps to the hypervisor to resync the shadow table.
+     * @param wasPresent The page was mapped before, so TLBs may cache it; mapping a
+     * not-present page needs no flush
+     */
+    void pteChanged(PageKey page, bool wasPresent = true) {
+        if (wasPresent) invalidateTlb(page);
+        unpublish(page);
+        if (!isVirtualized()) return;
+        ++guestPteWrites;
+        if (paging.mode == VirtMode::Shadow) trapTimeNs += paging.vmExitNs;
+    }
+
+    /**
+     * @brief Translate a guest frame through the host page table, populating it on a host fault
+     *
+     * Host frames are handed out in creation order; when they run out the oldest host
+     * mapping is reclaimed and TLB entries through it are invalidated.
+     */
+    void translateHost(size_t guestFrame) {
+        size_t group = paging.hostHugePages ? guestFrame / paging.hugePageFactor : guestFrame;
+        if (hostTable.count(group)) return;
+        ++hostFaults;
+        walkTimeNs += paging.vmExitNs;
+        size_t framesPerMapping = paging.hostHugePages ? paging.hugePageFactor : 1;
+        size_t capacity = std::max<size_t>(1, (paging.hostFrames ? paging.hostFrames : numFrames) / framesPerMapping);
+        size_t hostGroup = hostTable.size();
+        if (hostTable.size() >= capacity) {
+            size_t victim = hostFifo.front();
+            hostFifo.pop_front();
+            hostGroup = hostTable[victim];
+            hostTable.erase(victim);
+            ++hostEvictions;
+            for (size_t f = victim * framesPerMapping; f < (victim + 1) * framesPerMapping && f < numFrames; ++f) {
+                if (frameTable[f] == NO_PAGE) continue;
+                for (PageKey page : mappersOf(f)) invalidateTlb(page);
+            }
+        }
+        hostTable[group] = hostGroup;
+        hostFifo.push_back(group);
+    }
+
+    /**
+     * @brief Drop every TLB entry covering part of a page, on every core
+     *
+     * The core holding the mm lock flushes its own TLB. Every other core that may
+     * cache the page's address space gets a shootdown IPI, whether or not it holds
+     * this page: like Linux's mm_cpumask, only whole-TLB flushes take a core out of
+     * the set. Inside a batching reclaim pass the IPIs are queued.
+     */
+    void invalidateTlb(PageKey page) {
+        size_t segIdx = keySegment(page);
+        size_t frames = segments[segIdx].pageFrames, span = tlbSpan(frames);
+        size_t first = keyPage(page) * frames, space = segments[segIdx].space;
+        for (std::unique_ptr<CpuState>& state : cpus) {
+            size_t asid;
+            if (!liveAsid(*state, space, asid)) continue;
+            bool held = false;
+            for (size_t unit = first / span; unit <= (first + frames - 1) / span; ++unit) {
+                uint64_t key = pageKey(segIdx, unit) | static_cast<uint64_t>(asid) << ASID_SHIFT;
+                if (!state->tlb.invalidate(key)) continue;
+                state->carried.erase(key);
+                held = true;
+            }
+            if (state->id == currentCpu || !state->spacesCached.count(space)) continue;
+            state->ipiPending = true;
+            state->ipiNeeded = state->ipiNeeded || held;
+        }
+        if (shootdownBatchDepth == 0 || !shootdown.batchReclaim) sendShootdowns();
+    }
+
+    /**
+     * @brief Send the queued shootdown IPIs at once; the initiator waits for the last acknowledgement
+     */
+    void sendShootdowns() {
+        size_t targets = 0;
+        for (std::unique_ptr<CpuState>& state : cpus) {
+            if (!state->ipiPending) continue;
+            ++targets;
+            ++state->ipisReceived;
+            if (!state->ipiNeeded) ++wastedIpis;
+            state->ipiPending = state->ipiNeeded = false;
+        }
+        if (targets == 0) return;
+        ++shootdowns;
+        ipisSent += targets;
+        shootdownWaitNs += shootdown.ipiNs;
+        shootdownHandlerNs += targets * shootdown.handlerNs;
+    }
+
+    /**
+     * @brief Scope of a reclaim pass, whose shootdowns are sent together at its end when batching is on
+     */
+    class ShootdownBatch {
+        VirtualMemoryManager& vmm;
+
+    public:
+        explicit ShootdownBatch(VirtualMemoryManager& m) : vmm(m) { ++vmm.shootdownBatchDepth; }
+        ~ShootdownBatch() {
+            if (--vmm.shootdownBatchDepth == 0) vmm.sendShootdowns();
+        }
+    };
+
+    /**
+     * @brief Look up a base page in a core's TLB, switching the core to the page's address space first
+     * @param key Receives the ASID-tagged TLB key
+     */
+    bool coreTlbLookup(CpuState& state, size_t segIdx, size_t basePage, uint64_t& key) {
+        switchSpace(state, segments[segIdx].space);
+        key = tlbKey(segIdx, basePage) | static_cast<uint64_t>(state.asid) << ASID_SHIFT;
+        if (!state.tlb.lookup(key)) return false;
+        if (!state.carried.empty() && state.carried.erase(key)) ++switchSavedHits;
+        return true;
+    }
+
+    void coreTlbFill(CpuState& state, size_t segIdx, uint64_t key) {
+        state.tlb.insert(key);
+        state.carried.erase(key); // evicted since the switch, so later hits are on the refill
+        state.spacesCached.insert(segments[segIdx].space);
+    }
+
+    /**
+     * @brief Context switch a core to another address space
+     *
+     * Untagged TLBs are flushed. With ASIDs the space reuses its tag if the core
+     * still holds one from the current generation, so its entries survive;
+     * otherwise it takes the next free tag, and when the pool is used up the
+     * generation rolls over and the whole TLB is flushed.
+     */
+    void switchSpace(CpuState& state, size_t space) {
+        if (state.space == space) return;
+        ++contextSwitches;
+        state.space = space;
+        state.carried.clear();
+        if (asidCount == 0) {
+            flushCoreTlb(state);
+            return;
+        }
+        if (!liveAsid(state, space, state.asid)) {
+            assignAsid(state, space);
+            return;
+        }
+        size_t asid = state.asid;
+        state.tlb.forEach([&](uint64_t key) {
+            if (key >> ASID_SHIFT == asid) state.carried.insert(key);
+        });
+        keptEntries += state.carried.size();
+    }
+
+    /**
+     * @brief Tag a core's translations of a space carry, if its TLB can hold any
+     */
+    bool liveAsid(const CpuState& state, size_t space, size_t& asid) const {
+        asid = 0;
+        if (asidCount == 0) return true;
+        auto it = state.spaceAsids.find(space);
+        if (it == state.spaceAsids.end() || it->second.first != state.asidGeneration) return false;
+        asid = it->second.second;
+        return true;
+    }
+
+    void assignAsid(CpuState& state, size_t space) {
+        if (state.nextAsid > asidCount) {
+            ++asidRollovers;
+            ++state.asidGeneration;
+            flushCoreTlb(state);
+            state.nextAsid = 1;
+        }
+        state.asid = state.nextAsid++;
+        state.spaceAsids[space] = std::make_pair(state.asidGeneration, state.asid);
+    }
+
+    void flushCoreTlb(CpuState& state) {
+        ++tlbFlushes;
+        flushedEntries += state.tlb.size();
+        dropCoreTlb(state);
+    }
+
+    void dropCoreTlb(CpuState& state) {
+        state.tlb.flush();
+        state.spacesCached.clear();
+        state.carried.clear();
+    }
+
+    /**
+     * @brief Restart a core's ASID allocation, tagging the space it runs
+     */
+    void resetAsids(CpuState& state) {
+        dropCoreTlb(state);
+        state.spaceAsids.clear();
+        state.nextAsid = 1;
+        state.asid = 0;
+        if (asidCount > 0) assignAsid(state, state.space);
+    }
+
+    /**
+     * @brief Set the ASIDs per core (0 = untagged TLBs, flushed on every context switch); flushes every TLB
+     */
+    void setAsids(size_t count) {
+        ExclusiveGuard guard(*this);
+        asidCount = count > MAX_ASIDS ? MAX_ASIDS : count;
+        for (std::unique_ptr<CpuState>& state : cpus) resetAsids(*state);
+    }
+
+    size_t getAsids() const { return asidCount; }
+
+    /**
+     * @brief Move a segment to another address space; its cached translations are dropped from every TLB
+     */
+    bool setSegmentSpace(size_t segIdx, size_t space) {
+        ExclusiveGuard guard(*this);
+        if (segIdx >= segments.size() || !segments[segIdx].inUse) return false;
+        segments[segIdx].space = space;
+        for (std::unique_ptr<CpuState>& state : cpus) dropCoreTlb(*state);
+        return true;
+    }
+
+    /**
+     * @brief Set the cost of TLB shootdowns and whether reclaim batches them
+     */
+    void configureShootdowns(const ShootdownConfig& cfg) {
+        ExclusiveGuard guard(*this);
+        shootdown = cfg;
+    }
+
+    /**
+     * @brief Change TLB, page-walk and virtualization settings; flushes the TLB and host page table
+     */
+    void configurePaging(const PagingConfig& cfg) {
+        ExclusiveGuard guard(*this);
+        paging = cfg;
+        if (paging.guestLevels == 0) paging.guestLevels = 1;
+        if (paging.hostLevels == 0) paging.hostLevels = 1;
+        if (paging.hugePageFactor == 0) paging.hugePageFactor = 1;
+        for (std::unique_ptr<CpuState>& state : cpus) {
+            state->tlb.setCapacity(paging.tlbEntries);
+            dropCoreTlb(*state);
+        }
+        hostTable.clear();
+        hostFifo.clear();
+    }
+
+    /**
+     * @brief Simulated time: memory accesses plus page walks, host faults, shadow sync traps, segment growth, direct reclaim,
+     * dirty throttling and TLB shootdowns
+     */
+    double simTimeNs() const {
+        return memTimeNs + walkTimeNs + trapTimeNs + growthTimeNs + stallTimeNs + throttleTimeNs + shootdownWaitNs + shootdownHandlerNs;
+    }
+
+    /**
+     * @brief Handle a page fault using selected replacement policy
+     *
+     * New pages are always loaded into the fast tier. When it is full its victims are
+     * demoted to the slow tier; only victims of the slow tier (or of a single-tier
+     * memory) are swapped out. Pages of file-backed segments come from the page cache.
+     * @param page The page to load
+     * @return Major if the page was read from disk, OutOfMemory if pinned pages leave no room
+     */
+    FaultResult handlePageFault(PageKey page) {
+        if (segments[keySegment(page)].file >= 0) return fileFault(page);
+        int frame = allocateFrames(segments[keySegment(page)].pageFrames);
+        if (frame == -1) return FaultResult::OutOfMemory;
+        mapPage(page, static_cast<size_t>(frame));
+        bool major = swapIn(page, static_cast<size_t>(frame));
+        if (idleEvicted.erase(page)) ++idleRefaults;
+        if (pte(page).shadow != 0) refault(pte(page).shadow, static_cast<size_t>(frame));
+        pte(page).shadow = 0;
+        return major ? FaultResult::Major : FaultResult::Minor;
+    }
+
+    /**
+     * @brief Map a page of a file-backed segment to its page-cache frame, reading the file page in first if not cached
+     *
+     * A read also reads ahead the segment's following file pages, unless the segment
+     * is advised Random; they are read first so the faulting page is the newest.
+     * @return Major if the file page had to be read
+     */
+    FaultResult fileFault(PageKey page) {
+        const Segment& seg = segments[keySegment(page)];
+        PageKey filePage = filePageKey(static_cast<size_t>(seg.file), seg.fileOffset + keyPage(page));
+        auto cached = pageCache.find(filePage);
+        bool major = cached == pageCache.end();
+        size_t frame;
+        if (major) {
+            if (idleEvicted.erase(filePage)) ++idleRefaults;
+            size_t window = seg.access == Advice::Random ? 0 : seg.access == Advice::Sequential ? 2 * readaheadWindow : readaheadWindow;
+            for (size_t vpn = keyPage(page) + 1; vpn <= keyPage(page) + window && vpn < seg.pageTable.size(); ++vpn) {
+                PageKey ahead = filePageKey(static_cast<size_t>(seg.file), seg.fileOffset + vpn);
+                if (pageCache.count(ahead)) continue;
+                int read = readFilePage(ahead);
+                if (read == -1) break;
+                cachedFrames[static_cast<size_t>(read)].readAhead = true;
+                ++readaheadPages;
+            }
+            int read = readFilePage(filePage);
+            if (read == -1) return FaultResult::OutOfMemory;
+            frame = static_cast<size_t>(read);
+            auto shadow = files[keyFile(filePage)].shadows.find(keyPage(filePage));
+            if (shadow != files[keyFile(filePage)].shadows.end()) {
+                refault(shadow->second, frame);
+                files[keyFile(filePage)].shadows.erase(shadow);
+            }
+        } else {
+            frame = cached->second;
+            if (cachedFrames[frame].readAhead) ++readaheadHits;
+        }
+        cachedFrames[frame].readAhead = false;
+        cachedFrames[frame].mappers.push_back(page);
+        pte(page).frameNumber = static_cast<int>(frame);
+        pte(page).valid = true;
+        pteChanged(page, false);
+        return major ? FaultResult::Major : FaultResult::Minor;
+    }
+
+    /**
+     * @brief Read a file page into a new, unmapped page-cache frame
+     * @return The frame, or -1 if pinned pages leave no room
+     */
+    int readFilePage(PageKey filePage) {
+        int read = allocateFrames(1);
+        if (read == -1) return -1;
+        size_t frame = static_cast<size_t>(read);
+        frameTable[frame] = filePage;
+        pageCache[filePage] = frame;
+        idleEvicted.erase(filePage); // read ahead back in
+        cachedFrames[frame].filePage = filePage;
+        addToReplacement(frame);
+        const SimFile& f = files[keyFile(filePage)];
+        auto stored = f.pages.find(keyPage(filePage));
+        if (stored != f.pages.end()) std::copy(stored->second.begin(), stored->second.end(), physMem.begin() + frame * pageSize);
+        else std::fill(physMem.begin() + frame * pageSize, physMem.begin() + (frame + 1) * pageSize, 0);
+        ++fileReads;
+        return read;
+    }
+
+    /**
+     * @brief Drop a page from the page cache, unmapping it everywhere and writing it back to its file if dirty
+     */
+    void evictCached(size_t frame) {
+        revokeFrame(frame);
+        CachedPage& cached = cachedFrames[frame];
+        bool dirty = cached.dirty;
+        for (PageKey page : cached.mappers) {
+            PageTableEntry& entry = pte(page);
+            dirty = dirty || entry.dirty;
+            entry = PageTableEntry();
+            pteChanged(page);
+        }
+        PageKey filePage = frameTable[frame];
+        if (dirty) {
+            files[keyFile(filePage)].pages[keyPage(filePage)].assign(physMem.begin() + frame * pageSize,
+                                                                     physMem.begin() + (frame + 1) * pageSize);
+            ++fileWrites;
+        }
+        pageCache.erase(filePage);
+        cachedFrames.erase(frame);
+        dirtySince.erase(filePage);
+        files[keyFile(filePage)].shadows[keyPage(filePage)] = workingsetClock;
+        freeFrame(frame);
+    }
+
+    /**
+     * @brief Apply an madvise-style hint to the pages overlapping [offset, offset + length) of a segment
+     *
+     * Normal, Sequential and Random set the whole segment's readahead window.
+     * WillNeed loads the pages without counting faults, DontNeed unmaps them (file
+     * pages stay cached, anonymous pages and their swapped copies are discarded) and
+     * Cold moves resident pages to the oldest end of their inactive list. Locked pages are
+     * neither dropped nor deactivated.
+     * @return false for an invalid range, or if WillNeed ran out of unpinned memory
+     */
+    bool madvise(size_t segIdx, size_t offset, size_t length, Advice advice) {
+        ExclusiveGuard guard(*this);
+        if (segIdx >= segments.size() || !segments[segIdx].inUse || length == 0) return false;
+        Segment& seg = segments[segIdx];
+        if (advice == Advice::Normal || advice == Advice::Sequential || advice == Advice::Random) {
+            seg.access = advice;
+            return true;
+        }
+        if (offset >= seg.limit) return false;
+        length = std::min(length, seg.limit - offset);
+        size_t first = offset / pageBytes(seg);
+        size_t last = std::min((offset + length - 1) / pageBytes(seg), seg.pageTable.size() - 1);
+        for (size_t vpn = first; vpn <= last; ++vpn) {
+            PageKey page = pageKey(segIdx, vpn);
+            PageTableEntry& entry = seg.pageTable[vpn];
+            if (entry.locked) continue;
+            if (advice == Advice::WillNeed && !entry.valid) {
+                if (handlePageFault(page) == FaultResult::OutOfMemory) return false;
+                seg.pageTable[vpn].prefetched = true;
+                ++prefetchedPages;
+            } else if (advice == Advice::DontNeed && (entry.valid || seg.file < 0)) {
+                if (entry.valid) ++droppedPages;
+                discardPage(page);
+            } else if (advice == Advice::Cold && entry.valid) {
+                deactivate(static_cast<size_t>(entry.frameNumber));
+                ++coldPages;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Lock (mlock) or unlock (munlock) the pages overlapping [offset, offset + length) of a segment
+     *
+     * Locking loads missing pages and gives merged pages their own copy first, then
+     * moves their frames to the unevictable list. A shared file page stays pinned while
+     * any mapping of it is locked. Pages stay locked until unlocked or unmapped.
+     * @return false for an invalid range, or if pinned pages leave no room to load a page to lock
+     */
+    bool mlock(size_t segIdx, size_t offset, size_t length, bool lock) {
+        ExclusiveGuard guard(*this);
+        if (segIdx >= segments.size() || !segments[segIdx].inUse || length == 0) return false;
+        Segment& seg = segments[segIdx];
+        if (offset >= seg.limit) return false;
+        length = std::min(length, seg.limit - offset);
+        size_t first = offset / pageBytes(seg);
+        size_t last = std::min((offset + length - 1) / pageBytes(seg), seg.pageTable.size() - 1);
+        for (size_t vpn = first; vpn <= last; ++vpn) {
+            PageKey page = pageKey(segIdx, vpn);
+            if (seg.pageTable[vpn].locked == lock) continue;
+            if (lock && !seg.pageTable[vpn].valid && handlePageFault(page) == FaultResult::OutOfMemory) {
+                ++outOfMemory;
+                return false;
+            }
+            if (lock && seg.pageTable[vpn].merged) breakCow(page);
+            seg.pageTable[vpn].locked = lock;
+            if (lock) ++lockedPages;
+            else --lockedPages;
+            updateEvictable(static_cast<size_t>(seg.pageTable[vpn].frameNumber));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Move a frame between the unevictable list and an inactive list to match whether a mapper is locked
+     */
+    void updateEvictable(size_t frame) {
+        auto found = replacementPos.find(frame);
+        if (found == replacementPos.end()) return;
+        LruPos& pos = found->second;
+        bool pinned = false;
+        for (PageKey page : mappersOf(frame)) pinned = pinned || pte(page).locked;
+        if (pinned == (pos.list == LruList::Unevictable)) return;
+        LruList target = pinned ? LruList::Unevictable : cachedFrames.count(frame) ? LruList::InactiveFile : LruList::InactiveAnon;
+        std::list<size_t>& l = lruLists[static_cast<int>(target)];
+        l.splice(l.begin(), lruLists[static_cast<int>(pos.list)], pos.it);
+        pos.list = target;
+        pos.referenced = false;
+    }
+
+    /**
+     * @brief Index of a simulated file, registering it on first use
+     */
+    size_t fileIndex(const std::string& name) {
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (files[i].name == name) return i;
+        }
+        files.push_back(SimFile());
+        files.back().name = name;
+        return files.size() - 1;
+    }
+
+    /**
+     * @brief Map part of a file into a new segment (mmap with MAP_SHARED)
+     *
+     * Every segment mapping the same file page shares its page-cache frame, so a
+     * write through one mapping is seen by all of them.
+     * @param offset Byte offset in the file; must be a multiple of the page size
+     * @return Index of the new segment, or -1 if it does not fit
+     */
+    long mapFile(const std::string& name, size_t offset, size_t length) {
+        ExclusiveGuard guard(*this);
+        if (offset % pageSize != 0) return -1;
+        long idx = createSegment(name, length);
+        if (idx < 0) return -1;
+        segments[idx].file = static_cast<long>(fileIndex(name));
+        segments[idx].fileOffset = offset / pageSize;
+        return idx;
+    }
+
+    /**
+     * @brief Obtain an aligned run of empty fast-tier frames, reclaiming directly while none is free or below the min watermark
+     *
+     * If pinned pages leave no victim in the fast tier, the run is taken from the
+     * slow tier instead. Reclaim work done here stalls the faulting access.
+     * @return First frame of the run, or -1 if every page that could make room is pinned
+     */
+    int allocateFrames(size_t span) {
+        size_t reclaimedBefore = swapOuts + demotions;
+        double ns = 0.0;
+        int run = findFreeRun(0, fastFrames, span);
+        while (run == -1 || (reclaim.minFrames > 0 && freeFrames(0, fastFrames) < reclaim.minFrames + span)) {
+            if (reclaimFast(reclaim.batch, ns) == 0) break;
+            run = findFreeRun(0, fastFrames, span);
+        }
+        size_t slowFrames = numFrames - fastFrames;
+        if (run == -1 && isTiered() && runFits(fastFrames, slowFrames, span)) {
+            size_t slowBefore = swapOuts;
+            run = reclaimRun(fastFrames, slowFrames, span);
+            ns += (swapOuts - slowBefore) * reclaim.reclaimNsPerPage;
+        }
+        size_t pages = swapOuts + demotions - reclaimedBefore;
+        if (pages > 0) {
+            ++directStalls;
+            directPages += pages;
+            stallTimeNs += ns;
+            maxStallNs = std::max(maxStallNs, ns);
+        }
+        if (reclaim.highFrames > 0 && !kswapdAwake && freeFrames(0, fastFrames) < reclaim.lowFrames + (run != -1 ? span : 0)) {
+            kswapdAwake = true;
+            ++kswapdWakeups;
+        }
+        return run;
+    }
+
+    /**
+     * @brief One reclaim invocation: pick up to k fast-tier victims in one pass, then demote (or, in a single tier, swap out) them all
+     *
+     * The writebacks of the batch are submitted as one I/O, so the invocation costs
+     * its fixed overhead, the per-page unmapping, one submission if anything was
+     * written and the transfer of the written pages.
+     * @param costNs Receives the simulated time of the invocation (added to it)
+     * @return Victims reclaimed; 0 if every fast-tier page is pinned
+     */
+    size_t reclaimFast(size_t k, double& costNs) {
+        ShootdownBatch batch(*this);
+        std::vector<size_t> victims = selectVictims(0, fastFrames, k);
+        if (victims.empty()) return 0;
+        size_t pagesBefore = swapOuts + demotions, writesBefore = diskWrites + fileWrites;
+        for (size_t victim : victims) {
+            if (isTiered()) demoteFrame(victim);
+            else evictFrame(victim);
+        }
+        size_t pages = swapOuts + demotions - pagesBefore, writes = diskWrites + fileWrites - writesBefore;
+        ++reclaimInvocations;
+        reclaimWrites += writes;
+        if (writes > 0) ++ioSubmissions;
+        double ioNs = writes > 0 ? reclaim.ioSubmitNs + writes * reclaim.ioPageNs : 0.0;
+        ioWriteTimeNs += ioNs;
+        costNs += reclaim.invocationNs + pages * reclaim.reclaimNsPerPage + ioNs;
+        return victims.size();
+    }
+
+    /**
+     * @brief Let an awake kswapd run one reclaim invocation; it sleeps once the high watermark is met
+     */
+    void kswapdRun() {
+        if (!kswapdAwake) return;
+        size_t reclaimedBefore = swapOuts + demotions;
+        bool progress = freeFrames(0, fastFrames) < reclaim.highFrames && reclaimFast(reclaim.batch, kswapdTimeNs) > 0;
+        kswapdPages += swapOuts + demotions - reclaimedBefore;
+        if (!progress || freeFrames(0, fastFrames) >= reclaim.highFrames) kswapdAwake = false;
+    }
+
+    /**
+     * @brief Key under which a page's dirtiness is tracked: its file page for file-backed segments
+     */
+    PageKey dirtyKey(PageKey page) const {
+        const Segment& seg = segments[keySegment(page)];
+        return seg.file >= 0 ? filePageKey(static_cast<size_t>(seg.file), seg.fileOffset + keyPage(page)) : page;
+    }
+
+    /**
+     * @brief Whether a tracked anonymous page or file page is still resident and dirty
+     */
+    bool isDirty(PageKey key) const {
+        if (isFilePage(key)) {
+            auto cached = pageCache.find(key);
+            if (cached == pageCache.end()) return false;
+            const CachedPage& cp = cachedFrames.at(cached->second);
+            bool dirty = cp.dirty;
+            for (PageKey page : cp.mappers) dirty = dirty || pte(page).dirty;
+            return dirty;
+        }
+        const PageTableEntry* entry = findPte(key);
+        return entry && segments[keySegment(key)].file < 0 && entry->valid && entry->dirty;
+    }
+
+    /**
+     * @brief Record that a page became dirty, throttling the writer if dirty pages exceed the dirty ratio
+     */
+    void noteDirty(PageKey page) {
+        if (writeback.interval == 0) return;
+        PageKey key = dirtyKey(page);
+        if (dirtySince.count(key)) return;
+        dirtySince[key] = accesses;
+        if (writeback.dirtyRatio > 0 && dirtySince.size() > dirtyLimit(writeback.dirtyRatio)) throttleWriter();
+    }
+
+    size_t dirtyLimit(unsigned ratio) const { return numFrames * ratio / 100; }
+
+    /**
+     * @brief Dirty pages, oldest first, after dropping entries that were cleaned or unmapped
+     * @return Pairs of the access count when dirtied and the tracked key
+     */
+    std::vector<std::pair<size_t, PageKey>> dirtyByAge() {
+        std::vector<std::pair<size_t, PageKey>> dirty;
+        for (auto it = dirtySince.begin(); it != dirtySince.end();) {
+            if (!isDirty(it->first)) {
+                it = dirtySince.erase(it);
+                continue;
+            }
+            dirty.push_back(std::make_pair(it->second, it->first));
+            ++it;
+        }
+        std::sort(dirty.begin(), dirty.end());
+        return dirty;
+    }
+
+    /**
+     * @brief Write a dirty page to its backing store (the swap store, or its file) and mark it clean
+     */
+    void writeBack(PageKey key) {
+        if (isFilePage(key)) {
+            size_t frame = pageCache[key];
+            revokeFrame(frame, true);
+            CachedPage& cp = cachedFrames[frame];
+            files[keyFile(key)].pages[keyPage(key)].assign(physMem.begin() + frame * pageSize, physMem.begin() + (frame + 1) * pageSize);
+            cp.dirty = false;
+            for (PageKey page : cp.mappers) pte(page).dirty = false;
+            ++fileWrites;
+        } else {
+            PageTableEntry& entry = pte(key);
+            size_t frame = static_cast<size_t>(entry.frameNumber);
+            revokeFrame(frame, true);
+            swapStore[key].assign(physMem.begin() + frame * pageSize,
+                                  physMem.begin() + frame * pageSize + pageBytes(segments[keySegment(key)]));
+            entry.dirty = false;
+            ++diskWrites;
+        }
+        dirtySince.erase(key);
+    }
+
+    /**
+     * @brief One flusher wake-up: write back expired dirty pages, then the oldest while above the background ratio
+     *
+     * The pages written in one wake-up form one I/O submission.
+     */
+    void flushDirty() {
+        ++flusherWakeups;
+        std::vector<std::pair<size_t, PageKey>> dirty = dirtyByAge();
+        size_t background = dirtyLimit(writeback.backgroundRatio), written = 0;
+        for (const auto& d : dirty) {
+            bool expired = accesses - d.first >= writeback.expireAccesses;
+            if (!expired && dirty.size() - written <= background) break;
+            writeBack(d.second);
+            ++(expired ? flushedExpired : flushedBackground);
+            ++written;
+        }
+        if (written == 0) return;
+        flusherTimeNs += reclaim.ioSubmitNs + written * reclaim.ioPageNs;
+        ioWriteTimeNs += reclaim.ioSubmitNs + written * reclaim.ioPageNs;
+    }
+
+    /**
+     * @brief Throttle a writer that pushed dirty pages above the dirty ratio: it writes back the oldest until the background limit is met
+     */
+    void throttleWriter() {
+        std::vector<std::pair<size_t, PageKey>> dirty = dirtyByAge();
+        if (dirty.size() <= dirtyLimit(writeback.dirtyRatio)) return;
+        size_t background = dirtyLimit(writeback.backgroundRatio), written = 0;
+        while (dirty.size() - written > background) writeBack(dirty[written++].second);
+        ++throttledWrites;
+        throttledPages += written;
+        throttleTimeNs += reclaim.ioSubmitNs + written * reclaim.ioPageNs;
+        ioWriteTimeNs += reclaim.ioSubmitNs + written * reclaim.ioPageNs;
+    }
+
+    /**
+     * @brief Set the flusher interval, expiry age and dirty ratios; tracking starts with the pages dirty now
+     */
+    void configureWriteback(const WritebackConfig& cfg) {
+        ExclusiveGuard guard(*this);
+        writeback = cfg;
+        writeback.dirtyRatio = std::min(writeback.dirtyRatio, 100u);
+        writeback.backgroundRatio = std::min(writeback.backgroundRatio, writeback.dirtyRatio > 0 ? writeback.dirtyRatio : 100u);
+        dirtySince.clear();
+        if (writeback.interval == 0) return;
+        for (size_t s = 0; s < segments.size(); ++s) {
+            if (!segments[s].inUse) continue;
+            for (size_t vpn = 0; vpn < segments[s].pageTable.size(); ++vpn) {
+                const PageTableEntry& entry = segments[s].pageTable[vpn];
+                if (entry.valid && entry.dirty) dirtySince[dirtyKey(pageKey(s, vpn))] = accesses;
+            }
+        }
+        for (const auto& cached : cachedFrames) {
+            if (cached.second.dirty) dirtySince[cached.second.filePage] = accesses;
+        }
+    }
+
+    /**
+     * @brief Empty frames in [first, first + count)
+     */
+    size_t freeFrames(size_t first, size_t count) const {
+        return static_cast<size_t>(std::count(frameTable.begin() + first, frameTable.begin() + first + count, NO_PAGE));
+    }
+
+    /**
+     * @brief Set the free-frame watermarks; with kswapd they are clamped so that min <= low <= high < fast-tier frames
+     */
+    void configureReclaim(const ReclaimConfig& cfg) {
+        ExclusiveGuard guard(*this);
+        reclaim = cfg;
+        reclaim.minFrames = std::min(reclaim.minFrames, fastFrames - 1);
+        reclaim.highFrames = std::min(reclaim.highFrames, fastFrames - 1);
+        if (reclaim.highFrames > 0) {
+            reclaim.lowFrames = std::min(std::max(reclaim.lowFrames, reclaim.minFrames), reclaim.highFrames);
+            reclaim.minFrames = std::min(reclaim.minFrames, reclaim.lowFrames);
+        }
+        if (reclaim.batch == 0) reclaim.batch = 1;
+        if (reclaim.highFrames == 0) kswapdAwake = false;
+    }
+
+    /**
+     * @brief Evict victims resident in [first, first + count) until an aligned run of span frames there is empty
+     * @return First frame of the run, or -1 if no evictable page is left in range
+     */
+    int reclaimRun(size_t first, size_t count, size_t span) {
+        ShootdownBatch batch(*this);
+        int run = findFreeRun(first, count, span);
+        while (run == -1) {
+            int victim = selectVictim(first, count);
+            if (victim == -1) return -1;
+            evictFrame(static_cast<size_t>(victim));
+            run = findFreeRun(first, count, span);
+        }
+        return run;
+    }
+
+    /**
+     * @brief Map a page to an empty run of frames and make it resident
+     */
+    void mapPage(PageKey page, size_t frame) {
+        pte(page).frameNumber = static_cast<int>(frame);
+        pte(page).valid = true;
+        pteChanged(page, false);
+        size_t span = segments[keySegment(page)].pageFrames;
+        std::fill(frameTable.begin() + frame, frameTable.begin() + frame + span, page);
+        addToReplacement(frame);
+    }
+
+    /**
+     * @brief Release the frames of an unmapped page
+     */
+    void freeFrame(size_t frame) {
+        revokeFrame(frame);
+        size_t span = spanOf(frame);
+        std::fill(frameTable.begin() + frame, frameTable.begin() + frame + span, NO_PAGE);
+        frameSamples[frame] = 0;
+        accessBitmap[frame] = false;
+        idleAge[frame] = 0;
+        removeFromReplacement(frame);
+    }
+
+    /**
+     * @brief Pages mapping a frame: every sharer of a merged frame or mapper of a cached file page, otherwise its single page
+     */
+    std::vector<PageKey> mappersOf(size_t frame) const {
+        auto it = mergedFrames.find(frame);
+        if (it != mergedFrames.end()) return it->second.pages;
+        auto cached = cachedFrames.find(frame);
+        if (cached != cachedFrames.end()) return cached->second.mappers;
+        return std::vector<PageKey>(1, frameTable[frame]);
+    }
+
+    /**
+     * @brief Point every mapper of a frame at another frame (contents are handled by the caller)
+     */
+    void remapFrame(size_t from, size_t to) {
+        for (PageKey page : mappersOf(from)) {
+            pte(page).frameNumber = static_cast<int>(to);
+            pteChanged(page);
+        }
+        relabelShared(from, to);
+    }
+
+    /**
+     * @brief Move the merged-frame or page-cache bookkeeping of a frame to another frame number
+     */
+    void relabelShared(size_t from, size_t to) {
+        auto cached = cachedFrames.find(from);
+        if (cached != cachedFrames.end()) {
+            PageKey filePage = cached->second.filePage;
+            CachedPage moved = std::move(cached->second);
+            cachedFrames.erase(cached);
+            cachedFrames[to] = std::move(moved);
+            if (to < numFrames) pageCache[filePage] = to;
+            return;
+        }
+        auto merged = mergedFrames.find(from);
+        if (merged == mergedFrames.end()) return;
+        auto range = stableTree.equal_range(merged->second.hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == from) it->second = to;
+        }
+        MergedFrame moved = std::move(merged->second);
+        mergedFrames.erase(merged);
+        mergedFrames[to] = std::move(moved);
+    }
+
+    /**
+     * @brief Stop sharing a merged frame, dropping it from the stable tree
+     */
+    void dissolveMerged(size_t frame) {
+        auto merged = mergedFrames.find(frame);
+        if (merged == mergedFrames.end()) return;
+        auto range = stableTree.equal_range(merged->second.hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == frame) {
+                stableTree.erase(it);
+                break;
+            }
+        }
+        for (PageKey page : merged->second.pages) pte(page).merged = false;
+        mergedFrames.erase(merged);
+    }
+
+    /**
+     * @brief Give a page written through a merged mapping its own copy of the frame
+     */
+    void breakCow(PageKey page) {
+        size_t shared = static_cast<size_t>(pte(page).frameNumber);
+        MergedFrame& mf = mergedFrames[shared];
+        ++ksmUnmerges;
+        if (mf.pages.size() == 1) { // last mapper keeps the frame
+            dissolveMerged(shared);
+            return;
+        }
+        std::vector<unsigned char> contents(physMem.begin() + shared * pageSize, physMem.begin() + (shared + 1) * pageSize);
+        mf.pages.erase(std::find(mf.pages.begin(), mf.pages.end(), page));
+        frameTable[shared] = mf.pages.front();
+        pte(page).merged = false;
+        pte(page).valid = false;
+        pte(page).frameNumber = -1;
+        pteChanged(page);
+        // May evict the shared frame, so contents were copied first. Cannot fail: merged
+        // pages are never locked, so at least the shared frame is evictable.
+        size_t frame = static_cast<size_t>(allocateFrames(1));
+        mapPage(page, frame);
+        std::copy(contents.begin(), contents.end(), physMem.begin() + frame * pageSize);
+        pte(page).dirty = true;
+        noteDirty(page);
+    }
+
+    /**
+     * @brief FNV-1a hash of a frame's contents
+     */
+    uint64_t hashFrame(size_t frame) const {
+        uint64_t h = 14695981039346656037ull;
+        for (size_t i = frame * pageSize; i < (frame + 1) * pageSize; ++i) {
+            h ^= physMem[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    bool sameContents(size_t frameA, size_t frameB) const {
+        return std::equal(physMem.begin() + frameA * pageSize, physMem.begin() + (frameA + 1) * pageSize,
+                          physMem.begin() + frameB * pageSize);
+    }
+
+    /**
+     * @brief Merge an unmerged page into a frame with identical contents and free its own frame
+     */
+    void mergeInto(PageKey page, size_t shared) {
+        freeFrame(static_cast<size_t>(pte(page).frameNumber));
+        pte(page).frameNumber = static_cast<int>(shared);
+        pte(page).merged = true;
+        pteChanged(page);
+        mergedFrames[shared].pages.push_back(page);
+        ++ksmMerges;
+    }
+
+    /**
+     * @brief Page-table entry of a page if its segment still maps it
+     */
+    const PageTableEntry* findPte(PageKey page) const {
+        size_t segIdx = keySegment(page);
+        if (segIdx >= segments.size() || !segments[segIdx].inUse || keyPage(page) >= segments[segIdx].pageTable.size())
+            return nullptr;
+        return &pte(page);
+    }
+
+    /**
+     * @brief One wake-up of the same-page merging scanner
+     *
+     * Resident base-size pages are visited round-robin, segment by segment. A page
+     * whose contents match a frame in the stable tree is merged into it; a page
+     * matching another page seen in this pass (unstable tree) turns that page's frame
+     * into a new shared frame. Huge pages, file pages and locked pages are not merged.
+     */
+    void ksmScan() {
+        double budgetNs = simTimeNs() * ksm.cpuBudgetPercent / 100.0 - ksmScanTimeNs;
+        size_t allowed = budgetNs > 0 ? std::min<size_t>(ksm.pagesToScan, static_cast<size_t>(budgetNs / ksm.hashCostNs)) : 0;
+        size_t total = 0;
+        for (const auto& seg : segments) {
+            if (seg.inUse) total += seg.pageTable.size();
+        }
+        size_t scanned = 0;
+        for (size_t visited = 0; scanned < allowed && visited < total;) {
+            if (ksmCursorSeg >= segments.size()) {
+                ksmCursorSeg = ksmCursorPage = 0;
+                ++ksmFullScans;
+                unstableTree.clear();
+            }
+            const Segment& seg = segments[ksmCursorSeg];
+            if (!seg.inUse || ksmCursorPage >= seg.pageTable.size()) {
+                ++ksmCursorSeg;
+                ksmCursorPage = 0;
+                continue;
+            }
+            ++visited;
+            PageKey page = pageKey(ksmCursorSeg, ksmCursorPage++);
+            const PageTableEntry& entry = seg.pageTable[keyPage(page)];
+            if (!entry.valid || entry.merged || entry.locked || seg.pageFrames > 1 || seg.file >= 0) continue;
+            ++scanned;
+            size_t frame = static_cast<size_t>(entry.frameNumber);
+            revokeFrame(frame, true);
+            uint64_t h = hashFrame(frame);
+            bool done = false;
+            auto range = stableTree.equal_range(h);
+            for (auto it = range.first; it != range.second && !done; ++it) {
+                if (sameContents(it->second, frame)) {
+                    mergeInto(page, it->second);
+                    done = true;
+                }
+            }
+            if (done) continue;
+            auto cand = unstableTree.find(h);
+            if (cand != unstableTree.end() && cand->second != page) {
+                const PageTableEntry* other = findPte(cand->second);
+                const Segment& otherSeg = segments[keySegment(cand->second)];
+                bool mergeable = other && other->valid && !other->merged && !other->locked && otherSeg.pageFrames == 1 && otherSeg.file < 0;
+                size_t otherFrame = mergeable ? static_cast<size_t>(other->frameNumber) : 0;
+                if (mergeable) revokeFrame(otherFrame, true);
+                if (mergeable && sameContents(otherFrame, frame)) {
+                    MergedFrame mf;
+                    mf.hash = h;
+                    mf.pages.push_back(cand->second);
+                    mergedFrames[otherFrame] = mf;
+                    pte(cand->second).merged = true;
+                    stableTree.insert(std::make_pair(h, otherFrame));
+                    mergeInto(page, otherFrame);
+                    unstableTree.erase(cand);
+                    continue;
+                }
+            }
+            unstableTree[h] = page;
+        }
+        ksmScanned += scanned;
+        ksmScanTimeNs += scanned * ksm.hashCostNs;
+    }
+
+    /**
+     * @brief Configure the same-page merging scanner; merged pages stay merged when it stops
+     */
+    void configureKsm(const KsmConfig& cfg) {
+        ExclusiveGuard guard(*this);
+        ksm = cfg;
+        if (ksm.scanInterval == 0) ksm.scanInterval = 1;
+        if (ksm.hashCostNs <= 0) ksm.hashCostNs = 1.0;
+    }
+
+    /**
+     * @brief Fill a page's frames with its contents from the compressed pool, the backing store, or zeros
+     * @return true if the page was read from the backing store
+     */
+    bool swapIn(PageKey page, size_t frame) {
+        unsigned char* dst = &physMem[frame * pageSize];
+        if (zswap.load(page, dst)) {
+            pte(page).dirty = true; // the pool copy is gone and the backing store may be stale
+            noteDirty(page);
+            return false;
+        }
+        auto it = swapStore.find(page);
+        if (it == swapStore.end()) {
+            std::fill(dst, dst + pageBytes(segments[keySegment(page)]), 0);
+            return false;
+        }
+        std::copy(it->second.begin(), it->second.end(), dst);
+        ++diskReads;
+        return true;
+    }
+
+    /**
+     * @brief Save an evicted dirty page to the compressed pool, falling back to the backing store
+     *
+     * When the pool is full its oldest entries are written back to make room. Huge
+     * pages bypass the pool.
+     */
+    void swapOut(PageKey page, size_t frame) {
+        const unsigned char* src = &physMem[frame * pageSize];
+        size_t bytes = pageBytes(segments[keySegment(page)]);
+        if (zswapEnabled && bytes == pageSize) {
+            std::vector<unsigned char> compressed = lzCompress(src, pageSize);
+            while (true) {
+                CompressedPool::StoreResult result = zswap.store(page, compressed);
+                if (result == CompressedPool::StoreResult::Stored) return;
+                if (result == CompressedPool::StoreResult::Incompressible) break;
+                if (!writebackOldest()) {
+                    ++zswapFullRejects;
+                    break;
+                }
+            }
+        }
+        swapStore[page].assign(src, src + bytes);
+        ++diskWrites;
+    }
+
+    /**
+     * @brief Write the oldest compressed page back to the backing store
+     * @return false if the pool is empty
+     */
+    bool writebackOldest() {
+        PageKey page;
+        std::vector<unsigned char> contents;
+        if (!zswap.takeOldest(page, contents)) return false;
+        swapStore[page].swap(contents);
+        ++diskWrites;
+        return true;
+    }
+
+    /**
+     * @brief Enable or disable the compressed swap pool
+     * @param enabled Route evicted pages through the pool
+     * @param maxPoolBytes Pool size limit; entries beyond it are written back
+     */
+    void configureZswap(bool enabled, size_t maxPoolBytes) {
+        ExclusiveGuard guard(*this);
+        zswapEnabled = enabled;
+        zswap.setLimit(enabled ? maxPoolBytes : 0);
+        while (zswap.overLimit() || (!enabled && zswap.storedPages() > 0)) writebackOldest();
+    }
+
+    /**
+     * @brief Find span empty frames in [first, first + count), starting at a multiple of span
+     * @return First frame of the run, or -1 if there is none
+     */
+    int findFreeRun(size_t first, size_t count, size_t span) const {
+        for (size_t start = (first + span - 1) / span * span; start + span <= first + count; start += span) {
+            size_t i = start;
+            while (i < start + span && frameTable[i] == NO_PAGE) ++i;
+            if (i == start + span) return static_cast<int>(start);
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Whether [first, first + count) holds an aligned run of span frames at all
+     */
+    bool runFits(size_t first, size_t count, size_t span) const { return (first + span - 1) / span * span + span <= first + count; }
+
+    /**
+     * @brief Pick the replacement victim among pages resident in [first, first + count)
+     * @return First frame of the page, or -1 if none of them is evictable
+     */
+    int selectVictim(size_t first, size_t count) {
+        std::vector<size_t> victims = selectVictims(first, count, 1);
+        return victims.empty() ? -1 : static_cast<int>(victims.front());
+    }
+
+    /**
+     * @brief The page in [first, first + count) reclaim would most likely take next, without evicting it
+     *
+     * Unlike selectVictim this leaves the lists, the scan credits and the clean-first
+     * statistics alone: the type the credits favour next is searched first, its inactive
+     * list and then its active list from the oldest end, and under CFLRU the oldest clean
+     * page among the first cleanFirstWindow candidates wins.
+     * @return First frame of the page, or -1 if none of them is evictable
+     */
+    int peekVictim(size_t first, size_t count) const {
+        bool fileFirst = fileScanCredit + static_cast<long>(200 - swappiness) >= anonScanCredit + static_cast<long>(swappiness);
+        bool cleanFirst = policy == ReplacementPolicy::CFLRU;
+        for (bool file : {fileFirst, !fileFirst}) {
+            LruList inactive = file ? LruList::InactiveFile : LruList::InactiveAnon;
+            LruList active = file ? LruList::ActiveFile : LruList::ActiveAnon;
+            int oldest = -1;
+            size_t seen = 0;
+            for (LruList list : {inactive, active}) {
+                const std::list<size_t>& l = lruLists[static_cast<int>(list)];
+                for (auto it = l.rbegin(); it != l.rend(); ++it) {
+                    if (*it < first || *it >= first + count) continue;
+                    if (oldest == -1) oldest = static_cast<int>(*it);
+                    if (!cleanFirst || !frameDirty(*it)) return static_cast<int>(*it);
+                    if (++seen >= cleanFirstWindow) return oldest;
+                }
+            }
+            if (oldest != -1) return oldest;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Pick up to k replacement victims among pages resident in [first, first + count) in one pass
+     *
+     * For each victim the anonymous or file lists are chosen by weighted round robin,
+     * with weights swappiness and 200 - swappiness (as in the kernel's scan
+     * balancing); the other type is used when the chosen one has no page left in
+     * range. A type's lists are aged when it is first chosen.
+     * @return First frames of the victims, in eviction order
+     */
+    std::vector<size_t> selectVictims(size_t first, size_t count, size_t k) {
+        std::vector<size_t> victims;
+        std::vector<size_t> candidates[2]; ///< Per type (anonymous, file), oldest first
+        std::vector<bool> cleanAhead[2];   ///< Candidate is a clean page moved ahead of an older dirty one
+        bool scanned[2] = {false, false};
+        size_t next[2] = {0, 0};
+        while (victims.size() < k) {
+            anonScanCredit += swappiness;
+            fileScanCredit += 200 - swappiness;
+            bool fileFirst = fileScanCredit >= anonScanCredit;
+            (fileFirst ? fileScanCredit : anonScanCredit) -= 200;
+            bool picked = false;
+            for (bool file : {fileFirst, !fileFirst}) {
+                if (!scanned[file]) {
+                    candidates[file] = victimsOfType(file, first, count, k, cleanAhead[file]);
+                    scanned[file] = true;
+                }
+                if (next[file] < candidates[file].size()) {
+                    if (cleanAhead[file][next[file]]) ++cleanFirstPicks;
+                    victims.push_back(candidates[file][next[file]++]);
+                    picked = true;
+                    break;
+                }
+            }
+            if (!picked) break;
+        }
+        return victims;
+    }
+
+    /**
+     * @brief Up to k oldest inactive pages of one type in range, followed by the oldest active ones
+     *
+     * The active list is first aged into the inactive list until the inactive list is
+     * at least as long. Under CFLRU the clean pages among the oldest cleanFirstWindow
+     * candidates move ahead of the dirty ones, each group keeping its LRU order.
+     * @param cleanAhead Set per victim: a clean page moved ahead of an older dirty one
+     */
+    std::vector<size_t> victimsOfType(bool file, size_t first, size_t count, size_t k, std::vector<bool>& cleanAhead) {
+        LruList inactive = file ? LruList::InactiveFile : LruList::InactiveAnon;
+        LruList active = file ? LruList::ActiveFile : LruList::ActiveAnon;
+        std::list<size_t>& activeList = lruLists[static_cast<int>(active)];
+        std::list<size_t>& inactiveList = lruLists[static_cast<int>(inactive)];
+        while (!activeList.empty() && inactiveList.size() < activeList.size()) {
+            LruPos& pos = replacementPos[activeList.back()];
+            inactiveList.splice(inactiveList.begin(), activeList, pos.it);
+            pos.list = inactive;
+            pos.referenced = false;
+            ++deactivations;
+        }
+        bool cleanFirst = policy == ReplacementPolicy::CFLRU;
+        size_t want = cleanFirst ? std::max(k, cleanFirstWindow) : k;
+        std::vector<size_t> victims;
+        for (const std::list<size_t>* l : {&inactiveList, &activeList}) {
+            for (auto it = l->rbegin(); it != l->rend() && victims.size() < want; ++it) {
+                if (*it >= first && *it < first + count) victims.push_back(*it);
+            }
+        }
+        cleanAhead.assign(victims.size(), false);
+        if (cleanFirst) {
+            size_t window = std::min(cleanFirstWindow, victims.size()), clean = 0;
+            std::vector<size_t> dirty;
+            for (size_t i = 0; i < window; ++i) {
+                if (frameDirty(victims[i])) {
+                    dirty.push_back(victims[i]);
+                    continue;
+                }
+                cleanAhead[clean] = !dirty.empty();
+                victims[clean++] = victims[i];
+            }
+            std::copy(dirty.begin(), dirty.end(), victims.begin() + clean);
+            if (victims.size() > k) {
+                victims.resize(k);
+                cleanAhead.resize(k);
+            }
+        }
+        return victims;
+    }
+
+    /**
+     * @brief Whether evicting the page in a frame needs a write: a mapper or the cached file page is dirty
+     */
+    bool frameDirty(size_t frame) const {
+        auto cached = cachedFrames.find(frame);
+        bool dirty = cached != cachedFrames.end() && cached->second.dirty;
+        for (PageKey page : mappersOf(frame)) dirty = dirty || pte(page).dirty;
+        return dirty;
+    }
+
+    /**
+     * @brief Set the CFLRU clean-first window and switch to CFLRU; 0 switches CFLRU back to plain LRU
+     */
+    void setCleanFirstWindow(size_t pages) {
+        ExclusiveGuard guard(*this);
+        if (pages > 0) {
+            cleanFirstWindow = pages;
+            policy = ReplacementPolicy::CFLRU;
+        } else if (policy == ReplacementPolicy::CFLRU) {
+            policy = ReplacementPolicy::LRU;
+        }
+    }
+
+    void setSwappiness(unsigned value) {
+        ExclusiveGuard guard(*this);
+        swappiness = std::min(value, 200u);
+    }
+
+    /**
+     * @brief Swap out the pages mapping a frame and free its frames, leaving shadow entries with the workingset clock
+     */
+    void evictFrame(size_t frame) {
+        revokeFrame(frame);
+        ++swapOuts;
+        ++workingsetClock;
+        if (cachedFrames.count(frame)) {
+            ++fileEvictions;
+            evictCached(frame);
+            return;
+        }
+        ++anonEvictions;
+        std::vector<PageKey> victims = mappersOf(frame);
+        dissolveMerged(frame);
+        for (PageKey victimPage : victims) {
+            PageTableEntry& entry = pte(victimPage);
+            if (entry.dirty) swapOut(victimPage, frame);
+            dirtySince.erase(victimPage);
+            entry = PageTableEntry();
+            entry.shadow = workingsetClock;
+            pteChanged(victimPage);
+        }
+        freeFrame(frame);
+    }
+
+    /**
+     * @brief Move the page held by a run of frames into an empty run, keeping its replacement position
+     */
+    void moveFrame(size_t from, size_t to) {
+        revokeFrame(from);
+        size_t span = spanOf(from);
+        remapFrame(from, to);
+        for (size_t i = 0; i < span; ++i) {
+            frameTable[to + i] = frameTable[from + i];
+            frameTable[from + i] = NO_PAGE;
+        }
+        std::copy(physMem.begin() + from * pageSize, physMem.begin() + (from + span) * pageSize, physMem.begin() + to * pageSize);
+        frameSamples[from] = frameSamples[to] = 0;
+        accessBitmap[to] = accessBitmap[from];
+        idleAge[to] = idleAge[from];
+        accessBitmap[from] = false;
+        idleAge[from] = 0;
+        LruPos pos = replacementPos[from];
+        *pos.it = to;
+        replacementPos.erase(from);
+        replacementPos[to] = pos;
+    }
+
+    /**
+     * @brief Swap the pages held by two runs of frames of equal size, each keeping its replacement position
+     */
+    void exchangeFrames(size_t a, size_t b) {
+        revokeFrame(a);
+        revokeFrame(b);
+        size_t span = spanOf(a);
+        std::vector<PageKey> pagesA = mappersOf(a);
+        std::vector<PageKey> pagesB = mappersOf(b);
+        for (PageKey page : pagesA) {
+            pte(page).frameNumber = static_cast<int>(b);
+            pteChanged(page);
+        }
+        for (PageKey page : pagesB) {
+            pte(page).frameNumber = static_cast<int>(a);
+            pteChanged(page);
+        }
+        size_t spare = numFrames; // bookkeeping key outside the frame range
+        relabelShared(a, spare);
+        relabelShared(b, a);
+        relabelShared(spare, b);
+        std::swap_ranges(frameTable.begin() + a, frameTable.begin() + a + span, frameTable.begin() + b);
+        std::swap_ranges(physMem.begin() + a * pageSize, physMem.begin() + (a + span) * pageSize, physMem.begin() + b * pageSize);
+        frameSamples[a] = frameSamples[b] = 0;
+        std::vector<bool>::swap(accessBitmap[a], accessBitmap[b]);
+        std::swap(idleAge[a], idleAge[b]);
+        LruPos posA = replacementPos[a];
+        LruPos posB = replacementPos[b];
+        *posA.it = b;
+        *posB.it = a;
+        replacementPos[a] = posB;
+        replacementPos[b] = posA;
+    }
+
+    /**
+     * @brief Demote a fast-tier page to the slow tier, swapping out slow-tier victims if needed
+     *
+     * A page too large for the slow tier, or for the room pinned pages leave there,
+     * is swapped out instead.
+     */
+    void demoteFrame(size_t frame) {
+        size_t span = spanOf(frame), slowFrames = numFrames - fastFrames;
+        int target = runFits(fastFrames, slowFrames, span) ? reclaimRun(fastFrames, slowFrames, span) : -1;
+        if (target == -1) {
+            evictFrame(frame);
+            return;
+        }
+        moveFrame(frame, static_cast<size_t>(target));
+        ++demotions;
+    }
+
+    /**
+     * @brief Promote a slow-tier page, exchanging it with the coldest fast-tier page if the fast tier is full
+     *
+     * When the coldest fast-tier page has a different size, or every fast-tier page is
+     * pinned, the promotion is skipped.
+     */
+    void promoteFrame(size_t frame) {
+        size_t span = spanOf(frame);
+        int target = findFreeRun(0, fastFrames, span);
+        if (target == -1) {
+            target = peekVictim(0, fastFrames);
+            if (target == -1 || spanOf(static_cast<size_t>(target)) != span) {
+                frameSamples[frame] = 0;
+                return;
+            }
+            exchangeFrames(frame, static_cast<size_t>(target));
+            ++demotions;
+        } else {
+            moveFrame(frame, static_cast<size_t>(target));
+        }
+        ++promotions;
+    }
+
+    /**
+     * @brief Charge tier latency for an access and sample it for promotion
+     */
+    void recordTierAccess(size_t frame) {
+        bool fast = frame < fastFrames;
+        if (fast) {
+            ++fastAccesses;
+            memTimeNs += tiering.fastLatencyNs;
+        } else {
+            ++slowAccesses;
+            memTimeNs += tiering.slowLatencyNs;
+        }
+        if (!fast && accesses % tiering.sampleInterval == 0 && ++frameSamples[frame] >= tiering.promoteThreshold)
+            promoteFrame(frame);
+    }
+
+    bool isTiered() const { return fastFrames < numFrames; }
+
+    /**
+     * @brief Add a newly loaded page to the front of the inactive list of its type
+     */
+    void addToReplacement(size_t frame) {
+        LruList list = cachedFrames.count(frame) ? LruList::InactiveFile : LruList::InactiveAnon;
+        std::list<size_t>& l = lruLists[static_cast<int>(list)];
+        l.push_front(frame);
+        LruPos pos;
+        pos.list = list;
+        pos.it = l.begin();
+        pos.referenced = false;
+        replacementPos[frame] = pos;
+    }
+
+    /**
+     * @brief Remove a page from its replacement list
+     */
+    void removeFromReplacement(size_t frame) {
+        auto it = replacementPos.find(frame);
+        if (it != replacementPos.end()) {
+            lruLists[static_cast<int>(it->second.list)].erase(it->second.it);
+            replacementPos.erase(it);
+        }
+    }
+
+    /**
+     * @brief Move a page to the oldest end of the inactive list of its type, clearing its referenced mark,
+     * so it is the next victim of its type
+     */
+    void deactivate(size_t frame) {
+        auto found = replacementPos.find(frame);
+        if (found == replacementPos.end() || found->second.list == LruList::Unevictable) return;
+        LruPos& pos = found->second;
+        bool file = pos.list == LruList::InactiveFile || pos.list == LruList::ActiveFile;
+        LruList inactive = file ? LruList::InactiveFile : LruList::InactiveAnon;
+        std::list<size_t>& target = lruLists[static_cast<int>(inactive)];
+        target.splice(target.end(), lruLists[static_cast<int>(pos.list)], pos.it);
+        pos.list = inactive;
+        pos.referenced = false;
+    }
+
+    /**
+     * @brief Record an access (mark_page_accessed)
+     *
+     * An inactive page is marked referenced on its first access and moved to the
+     * front of the active list on the second; an active page moves to the front of
+     * its list. Unevictable pages are not aged.
+     */
+    void markAccessed(size_t frame) {
+        auto found = replacementPos.find(frame);
+        if (found == replacementPos.end() || found->second.list == LruList::Unevictable) return;
+        LruPos& pos = found->second;
+        std::list<size_t>& current = lruLists[static_cast<int>(pos.list)];
+        if (pos.list == LruList::ActiveAnon || pos.list == LruList::ActiveFile) {
+            current.splice(current.begin(), current, pos.it);
+            return;
+        }
+        if (!pos.referenced) {
+            pos.referenced = true;
+            return;
+        }
+        activate(frame);
+    }
+
+    /**
+     * @brief Move a page to the front of the active list of its type
+     */
+    void activate(size_t frame) {
+        auto found = replacementPos.find(frame);
+        if (found == replacementPos.end()) return;
+        LruPos& pos = found->second;
+        if (pos.list != LruList::InactiveAnon && pos.list != LruList::InactiveFile) return;
+        LruList active = pos.list == LruList::InactiveAnon ? LruList::ActiveAnon : LruList::ActiveFile;
+        std::list<size_t>& target = lruLists[static_cast<int>(active)];
+        target.splice(target.begin(), lruLists[static_cast<int>(pos.list)], pos.it);
+        pos.list = active;
+        pos.referenced = false;
+        ++activations;
+        ++workingsetClock;
+    }
+
+    /**
+     * @brief Workingset detection for a page loaded again after eviction
+     *
+     * The refault distance is how far the workingset clock (evictions plus
+     * activations) advanced since the eviction: roughly how many more frames would
+     * have kept the page resident. A page whose distance fits in the active lists
+     * belongs to the working set and is activated at once (except under FIFO).
+     * @param evictedAt Workingset clock stored in the shadow entry
+     */
+    void refault(uint64_t evictedAt, size_t frame) {
+        uint64_t distance = workingsetClock - evictedAt;
+        size_t bucket = 0;
+        while (bucket < 63 && distance >= (static_cast<uint64_t>(1) << bucket)) ++bucket;
+        if (refaultHistogram.size() <= bucket) refaultHistogram.resize(bucket + 1, 0);
+        ++refaultHistogram[bucket];
+        ++refaults;
+        size_t reach = lruLists[static_cast<int>(LruList::ActiveAnon)].size() + lruLists[static_cast<int>(LruList::ActiveFile)].size();
+        if (policy != ReplacementPolicy::FIFO && distance <= reach) {
+            activate(frame);
+            ++refaultActivations;
+        }
+    }
+
+    uint64_t damonRandom() {
+        damonRng ^= damonRng << 13;
+        damonRng ^= damonRng >> 7;
+        damonRng ^= damonRng << 17;
+        return damonRng;
+    }
+
+    /**
+     * @brief Fit the monitoring regions to the segments: drop regions of destroyed segments, follow growth and shrinking
+     *
+     * A segment without regions gets one covering it.
+     */
+    void damonSyncRegions() {
+        std::vector<DamonRegion> synced;
+        size_t r = 0;
+        for (size_t s = 0; s < segments.size(); ++s) {
+            size_t pages = segments[s].pageTable.size();
+            size_t first = synced.size();
+            for (; r < damonRegions.size() && damonRegions[r].seg == s; ++r) {
+                if (!segments[s].inUse || damonRegions[r].start >= pages) continue;
+                synced.push_back(damonRegions[r]);
+            }
+            if (!segments[s].inUse || pages == 0) {
+                synced.resize(first);
+                continue;
+            }
+            if (synced.size() == first) {
+                DamonRegion region = DamonRegion();
+                region.seg = s;
+                synced.push_back(region);
+            }
+            synced[first].start = 0;
+            for (size_t i = first + 1; i < synced.size(); ++i) synced[i].start = synced[i - 1].end;
+            synced.back().end = pages;
+        }
+        damonRegions.swap(synced);
+    }
+
+    /**
+     * @brief One sampling step: count regions whose sampled page was accessed, then clear the accessed bit of a new sample
+     */
+    void damonSample() {
+        damonSyncRegions();
+        for (DamonRegion& region : damonRegions) {
+            std::vector<PageTableEntry>& table = segments[region.seg].pageTable;
+            if (region.sample >= region.start && region.sample < region.end && table[region.sample].accessed) ++region.nrAccesses;
+            region.sample = region.start + static_cast<size_t>(damonRandom() % (region.end - region.start));
+            table[region.sample].accessed = false;
+            ++damonChecks;
+        }
+        if (++damonSamples % damon.aggregateSamples == 0) damonAggregate();
+    }
+
+    /**
+     * @brief End of an aggregation: merge similar neighbours, age regions, page out cold ones and split to keep adapting
+     */
+    void damonAggregate() {
+        ++damonAggregations;
+        size_t maxNr = 0;
+        for (const DamonRegion& region : damonRegions) maxNr = std::max(maxNr, region.nrAccesses);
+        size_t threshold = std::max<size_t>(1, maxNr / 10); // similarity is relative to the hottest region
+        for (DamonRegion& region : damonRegions) {
+            size_t change = region.nrAccesses > region.lastNrAccesses ? region.nrAccesses - region.lastNrAccesses
+                                                                       : region.lastNrAccesses - region.nrAccesses;
+            region.age = change <= threshold ? region.age + 1 : 0;
+        }
+        std::vector<DamonRegion> merged;
+        for (const DamonRegion& region : damonRegions) {
+            if (!merged.empty() && damonRegions.size() - (&region - &damonRegions[0]) + merged.size() > damon.minRegions) {
+                DamonRegion& prev = merged.back();
+                size_t diff = prev.nrAccesses > region.nrAccesses ? prev.nrAccesses - region.nrAccesses : region.nrAccesses - prev.nrAccesses;
+                if (prev.seg == region.seg && diff <= threshold) {
+                    size_t a = prev.end - prev.start, b = region.end - region.start;
+                    prev.nrAccesses = (prev.nrAccesses * a + region.nrAccesses * b) / (a + b);
+                    prev.age = (prev.age * a + region.age * b) / (a + b);
+                    prev.end = region.end;
+                    continue;
+                }
+            }
+            merged.push_back(region);
+        }
+        damonRegions.swap(merged);
+        if (damon.coldAge > 0) {
+            for (const DamonRegion& region : damonRegions) {
+                if (region.nrAccesses == 0 && region.age >= damon.coldAge) damonPageout(region);
+            }
+        }
+        for (DamonRegion& region : damonRegions) {
+            region.lastNrAccesses = region.nrAccesses;
+            region.nrAccesses = 0;
+        }
+        if (damonRegions.size() >= damon.maxRegions / 2) return;
+        std::vector<DamonRegion> split;
+        for (const DamonRegion& region : damonRegions) {
+            size_t pages = region.end - region.start;
+            if (pages < 2 || split.size() + 2 > damon.maxRegions) {
+                split.push_back(region);
+                continue;
+            }
+            size_t at = region.start + 1 + static_cast<size_t>(damonRandom() % (pages - 1));
+            DamonRegion low = region, high = region;
+            low.end = high.start = at;
+            split.push_back(low);
+            split.push_back(high);
+        }
+        damonRegions.swap(split);
+    }
+
+    /**
+     * @brief Proactively reclaim the resident, evictable pages of a cold region
+     */
+    void damonPageout(const DamonRegion& region) {
+        ShootdownBatch batch(*this);
+        for (size_t vpn = region.start; vpn < region.end; ++vpn) {
+            const PageTableEntry& entry = segments[region.seg].pageTable[vpn];
+            if (!entry.valid) continue;
+            auto pos = replacementPos.find(static_cast<size_t>(entry.frameNumber));
+            if (pos == replacementPos.end() || pos->second.list == LruList::Unevictable) continue;
+            evictFrame(pos->first);
+            ++damonPageouts;
+        }
+    }
+
+    /**
+     * @brief Idle-page scan: age frames whose bit stayed clear, clear the bitmap and reclaim pages idle for long enough
+     *
+     * Locked pages are never reclaimed.
+     */
+    void idleScan() {
+        ++idleScanRuns;
+        std::vector<size_t> idle;
+        for (int list = 0; list < static_cast<int>(LruList::Unevictable); ++list) {
+            for (size_t frame : lruLists[list]) {
+                idleAge[frame] = accessBitmap[frame] ? 0 : idleAge[frame] + 1;
+                if (idleAge[frame] >= idleReclaim.idleScans) idle.push_back(frame);
+            }
+        }
+        std::fill(accessBitmap.begin(), accessBitmap.end(), false);
+        ShootdownBatch batch(*this);
+        for (size_t frame : idle) {
+            if (cachedFrames.count(frame)) idleEvicted.insert(frameTable[frame]);
+            else for (PageKey page : mappersOf(frame)) idleEvicted.insert(page);
+            evictFrame(frame);
+            ++idleReclaimed;
+        }
+    }
+
+    /**
+     * @brief Configure proactive idle-page reclaim; page ages restart
+     */
+    void configureIdleReclaim(const IdleReclaimConfig& cfg) {
+        ExclusiveGuard guard(*this);
+        idleReclaim = cfg;
+        if (idleReclaim.idleScans == 0) idleReclaim.idleScans = 1;
+        std::fill(idleAge.begin(), idleAge.end(), 0);
+    }
+
+    /**
+     * @brief Configure the access monitor; regions restart from one per segment
+     */
+    void configureDamon(const DamonConfig& cfg) {
+        ExclusiveGuard guard(*this);
+        damon = cfg;
+        if (damon.aggregateSamples == 0) damon.aggregateSamples = 1;
+        if (damon.maxRegions < 3) damon.maxRegions = 3;
+        damon.minRegions = std::min(damon.minRegions, damon.maxRegions);
+        damonRegions.clear();
+        damonSyncRegions();
+    }
+
+    /**
+     * @brief Show the monitored regions with their access frequency in the last aggregation (hot/cold report)
+     */
+    void showAccessReport() const {
+        ExclusiveGuard guard(*this);
+        if (damon.sampleInterval == 0) {
+            std::cout << "Access monitoring is off.\n";
+            return;
+        }
+        std::cout << "\nAccess report (" << damonRegions.size() << " regions, last aggregation of " << damon.aggregateSamples
+                  << " samples):\n";
+        size_t accessed = 0, idle = 0;
+        for (const DamonRegion& region : damonRegions) {
+            size_t pages = region.end - region.start;
+            size_t percent = 100 * region.lastNrAccesses / damon.aggregateSamples;
+            (region.lastNrAccesses > 0 ? accessed : idle) += pages;
+            std::cout << "  " << region.seg << ": " << segments[region.seg].name << " pages " << region.start << "-" << region.end - 1
+                      << ": accessed in " << percent << "% of samples, age " << region.age << '\n';
+        }
+        std::cout << "Pages in accessed regions: " << accessed << ", in idle regions: " << idle << '\n';
+    }
+
+    /**
+     * @brief Show statistics (accesses, page faults, fault rate)
+     */
+    void showStats() const {
+        ExclusiveGuard guard(*this);
+        std::cout << "\nStatistics:\n";
+        std::cout << "Total accesses: " << accesses << '\n';
+        std::cout << "Page faults: " << pageFaults << " (minor " << pageFaults - majorFaults << ", major " << majorFaults << ")\n";
+        if (accesses > 0)
+            std::cout << "Page fault rate: " << std::fixed << std::setprecision(2) << (100.0 * pageFaults / accesses) << "%\n";
+        std::cout << "Per segment:\n";
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const Segment& seg = segments[i];
+            if (!seg.inUse) continue;
+            size_t resident = 0, locked = 0;
+            for (const auto& entry : seg.pageTable) {
+                resident += entry.valid ? 1 : 0;
+                locked += entry.locked ? 1 : 0;
+            }
+            std::cout << "  " << i << ": " << seg.name << " (" << (seg.file >= 0 ? "file, " : "") << pageBytes(seg)
+                      << "-byte pages): " << seg.accesses << " accesses, " << seg.faults << " faults (" << seg.majorFaults
+                      << " major)";
+            if (seg.accesses > 0)
+                std::cout << ", fault rate " << std::fixed << std::setprecision(2) << (100.0 * seg.faults / seg.accesses) << "%";
+            std::cout << ", " << seg.tlbMisses << " TLB misses, " << resident << "/" << seg.pageTable.size()
+                      << " pages resident";
+            if (locked > 0) std::cout << " (" << locked << " locked)";
+            std::cout << '\n';
+        }
+        if (isTiered()) {
+            std::cout << "Fast tier: " << fastFrames << " frames (" << tiering.fastLatencyNs << " ns), slow tier: "
+                      << numFrames - fastFrames << " frames (" << tiering.slowLatencyNs << " ns)\n";
+            std::cout << "Fast-tier accesses: " << fastAccesses << ", slow-tier accesses: " << slowAccesses << '\n';
+            std::cout << "Promotions: " << promotions << ", demotions: " << demotions << ", swap-outs: " << swapOuts << '\n';
+            if (accesses > 0) {
+                double avgNs = memTimeNs / accesses;
+                std::cout << "Fast-tier hit ratio: " << (100.0 * fastAccesses / accesses) << "%\n";
+                std::cout << "Average access latency: " << avgNs << " ns (slowdown vs. all-fast: "
+                          << avgNs / tiering.fastLatencyNs << "x)\n";
+            }
+        }
+        std::cout << "Anonymous lists: " << lruLists[static_cast<int>(LruList::ActiveAnon)].size() << " active, "
+                  << lruLists[static_cast<int>(LruList::InactiveAnon)].size() << " inactive; file lists: "
+                  << lruLists[static_cast<int>(LruList::ActiveFile)].size() << " active, "
+                  << lruLists[static_cast<int>(LruList::InactiveFile)].size() << " inactive (swappiness " << swappiness << ")\n";
+        std::cout << "Activations: " << activations << ", deactivations: " << deactivations << ", evictions: "
+                  << anonEvictions << " anonymous, " << fileEvictions << " file\n";
+        if (refaults > 0) {
+            std::cout << "Refaults: " << refaults << " (" << refaultActivations << " within working-set reach, activated)\n";
+            std::cout << "Refault distance histogram (evictions and activations since eviction):\n";
+            for (size_t b = 0; b < refaultHistogram.size(); ++b) {
+                if (refaultHistogram[b] == 0) continue;
+                uint64_t lo = b == 0 ? 0 : static_cast<uint64_t>(1) << (b - 1), hi = b == 0 ? 0 : (static_cast<uint64_t>(1) << b) - 1;
+                std::cout << "  " << lo;
+                if (hi > lo) std::cout << "-" << hi;
+                std::cout << ": " << refaultHistogram[b] << '\n';
+            }
+        }
+        if (policy == ReplacementPolicy::CFLRU || cleanFirstPicks > 0)
+            std::cout << "Clean-first window: " << cleanFirstWindow << " pages, " << cleanFirstPicks
+                      << " victims chosen over an older dirty page\n";
+        if (lockedPages > 0 || outOfMemory > 0) {
+            size_t pinnedFrames = 0;
+            for (size_t frame : lruLists[static_cast<int>(LruList::Unevictable)]) pinnedFrames += spanOf(frame);
+            std::cout << "Locked: " << lockedPages << " pages pinning " << pinnedFrames << " frames (unevictable list), "
+                      << numFrames - pinnedFrames << " of " << numFrames << " frames left for everything else\n";
+            std::cout << "Out of memory (every resident page pinned): " << outOfMemory << " failed faults\n";
+        }
+        if (damon.sampleInterval > 0)
+            std::cout << "Access monitor: " << damonRegions.size() << " regions, " << damonSamples << " samples, " << damonChecks
+                      << " page checks, " << damonAggregations << " aggregations, " << damonPageouts << " cold pages reclaimed\n";
+        if (idleReclaim.scanInterval > 0 || idleReclaimed > 0) {
+            std::cout << "Idle-page reclaim: " << idleScanRuns << " scans, " << idleReclaimed << " pages reclaimed after "
+                      << idleReclaim.idleScans << " idle scans, " << idleRefaults << " faulted back\n";
+            size_t savedBytes = 0;
+            for (PageKey page : idleEvicted) savedBytes += isFilePage(page) ? pageSize : pageBytes(segments[keySegment(page)]);
+            std::cout << "Memory saved: " << idleEvicted.size() << " pages (" << savedBytes << " bytes) still out, against "
+                      << idleRefaults << " refaults caused\n";
+        }
+        std::cout << "Reclaim: " << reclaimInvocations << " invocations (batch " << reclaim.batch << "), "
+                  << ioSubmissions << " I/O submissions for " << reclaimWrites << " written pages\n";
+        std::cout << "Direct reclaim: " << directStalls << " stalls, " << directPages << " pages, " << stallTimeNs
+                  << " ns stalled";
+        if (directStalls > 0) std::cout << " (average " << stallTimeNs / directStalls << " ns, max " << maxStallNs << " ns)";
+        std::cout << '\n';
+        if (pageFaults > 0)
+            std::cout << "Fault-path reclaim latency: " << stallTimeNs / pageFaults << " ns per fault; throughput: "
+                      << (simTimeNs() > 0 ? accesses * 1e6 / simTimeNs() : 0.0) << " accesses per simulated ms\n";
+        if (writeback.interval > 0 || flusherWakeups > 0) {
+            std::cout << "Dirty pages: " << dirtySince.size() << " tracked (background limit " << dirtyLimit(writeback.backgroundRatio)
+                      << ", throttle limit " << dirtyLimit(writeback.dirtyRatio) << ")\n";
+            std::cout << "Flusher: " << flusherWakeups << " wake-ups, " << flushedExpired + flushedBackground << " pages written ("
+                      << flushedExpired << " expired, " << flushedBackground << " over background ratio), " << flusherTimeNs
+                      << " ns\n";
+            std::cout << "Throttled writers: " << throttledWrites << ", " << throttledPages << " pages written, "
+                      << throttleTimeNs << " ns stalled\n";
+        }
+        if (reclaim.highFrames > 0 || kswapdWakeups > 0) {
+            std::cout << "Watermarks (free fast-tier frames): min " << reclaim.minFrames << ", low " << reclaim.lowFrames
+                      << ", high " << reclaim.highFrames << "; " << freeFrames(0, fastFrames) << " free now\n";
+            std::cout << "kswapd: " << kswapdWakeups << " wake-ups, " << kswapdPages << " pages reclaimed in the background ("
+                      << kswapdTimeNs << " ns)\n";
+        }
+        std::cout << "Swap disk reads: " << diskReads << ", disk writes: " << diskWrites << '\n';
+        double ioReadTimeNs = (diskReads + fileReads) * reclaim.ioReadNs;
+        std::cout << "I/O time: " << ioReadTimeNs << " ns reading " << diskReads + fileReads << " pages, " << ioWriteTimeNs
+                  << " ns writing back, " << ioReadTimeNs + ioWriteTimeNs << " ns in total\n";
+        if (readaheadPages + prefetchedPages + droppedPages + coldPages > 0) {
+            std::cout << "Readahead: " << readaheadPages << " pages read ahead, " << readaheadHits
+                      << " of them faulted on later (minor instead of major)\n";
+            std::cout << "Hints: WILLNEED loaded " << prefetchedPages << " pages (" << prefetchHits
+                      << " accessed while still loaded), DONTNEED dropped " << droppedPages << " resident pages, COLD deactivated "
+                      << coldPages << " pages\n";
+        }
+        if (!files.empty()) {
+            size_t unmapped = 0;
+            for (const auto& cached : cachedFrames) unmapped += cached.second.mappers.empty() ? 1 : 0;
+            std::cout << "Page cache: " << pageCache.size() << " pages of " << files.size() << " files (" << unmapped
+                      << " not mapped), file reads: " << fileReads << ", writebacks: " << fileWrites << '\n';
+        }
+        size_t tlbHits = 0, tlbMisses = 0, maxIpis = 0;
+        for (const std::unique_ptr<CpuState>& state : cpus) {
+            tlbHits += state->tlb.hits;
+            tlbMisses += state->tlb.misses;
+            maxIpis = std::max(maxIpis, state->ipisReceived);
+        }
+        std::cout << "TLB hits: " << tlbHits << ", misses: " << tlbMisses;
+        if (accesses > 0) std::cout << " (hit ratio " << (100.0 * tlbHits / accesses) << "%)";
+        if (cpus.size() > 1) std::cout << " over " << cpus.size() << " per-core TLBs";
+        std::cout << '\n';
+        if (shootdowns > 0) {
+            const double CYCLES_PER_NS = 3.0; // 3 GHz cores
+            double seconds = simTimeNs() / 1e9;
+            std::cout << "TLB shootdowns: " << shootdowns << " (" << ipisSent << " IPIs, " << wastedIpis
+                      << " to cores caching none of the flushed pages, at most " << maxIpis << " received by one core)";
+            if (seconds > 0) std::cout << ", " << shootdowns / seconds << " per simulated second";
+            std::cout << '\n';
+            std::cout << "Shootdown cost: " << (shootdownWaitNs + shootdownHandlerNs) * CYCLES_PER_NS
+                      << " cycles lost at 3 GHz (initiators waiting " << shootdownWaitNs << " ns, handlers "
+                      << shootdownHandlerNs << " ns" << (shootdown.batchReclaim ? ", reclaim batched" : "") << ")\n";
+        }
+        if (contextSwitches > 0) {
+            std::cout << "Context switches: " << contextSwitches << " (";
+            if (asidCount > 0) std::cout << asidCount << " ASIDs per core";
+            else std::cout << "untagged TLBs, flushed on every switch";
+            std::cout << "), " << tlbFlushes << " TLB flushes dropping " << flushedEntries << " entries, "
+                      << asidRollovers << " ASID rollovers\n";
+            if (asidCount > 0) {
+                std::cout << "Tagged TLB: " << keptEntries << " entries kept across switches, " << switchSavedHits
+                          << " hits on them";
+                if (tlbMisses > 0)
+                    std::cout << " (page walks saved over flush-on-switch, about "
+                              << switchSavedHits * walkTimeNs / tlbMisses << " ns)";
+                std::cout << '\n';
+            }
+        }
+        static const char* const modeNames[] = {"Native", "Nested", "Shadow"};
+        std::cout << modeNames[static_cast<int>(paging.mode)] << " page walk: " << walkLength(1)
+                  << " references per TLB miss (" << walkLength(2) << " for huge pages), " << walkRefs
+                  << " references in total\n";
+        if (isVirtualized())
+            std::cout << "Host faults: " << hostFaults << ", host evictions: " << hostEvictions << '\n';
+        std::cout << "Translation cost: " << walkTimeNs + trapTimeNs << " ns";
+        if (tlbMisses > 0) std::cout << " (" << walkTimeNs / tlbMisses << " ns per TLB miss)";
+        std::cout << '\n';
+        if (isVirtualized()) {
+            double nestedMissNs = nestedWalkRefs * paging.walkRefNs;
+            double shadowMissNs = shadowWalkRefs * paging.walkRefNs;
+            double shadowTrapNs = guestPteWrites * paging.vmExitNs;
+            std::cout << "Nested vs. shadow paging (" << guestPteWrites << " guest page-table writes):\n";
+            std::cout << "  Nested: TLB-miss cost " << nestedMissNs << " ns, update-trap cost 0.00 ns, total "
+                      << nestedMissNs << " ns\n";
+            std::cout << "  Shadow: TLB-miss cost " << shadowMissNs << " ns, update-trap cost " << shadowTrapNs
+                      << " ns, total " << shadowMissNs + shadowTrapNs << " ns\n";
+        }
+        if (zswapEnabled || zswap.stores > 0) {
+            size_t stored = zswap.storedPages();
+            std::cout << "Compressed pool: " << stored << " pages, " << zswap.compressedBytes() << " compressed bytes in "
+                      << zswap.arenaBytes() << " arena bytes (limit " << zswap.limit() << ")\n";
+            if (zswap.limit() > 0)
+                std::cout << "Pool occupancy: " << (100.0 * zswap.arenaBytes() / zswap.limit()) << "%\n";
+            if (zswap.compressedBytes() > 0)
+                std::cout << "Compression ratio: " << (1.0 * stored * pageSize / zswap.compressedBytes())
+                          << " (arena: " << (1.0 * stored * pageSize / zswap.arenaBytes()) << ")\n";
+            std::cout << "Pool stores: " << zswap.stores << ", loads: " << zswap.loads << ", writebacks: " << zswap.writebacks
+                      << ", rejected: " << zswap.rejects << " incompressible, " << zswapFullRejects << " pool full\n";
+            std::cout << "Disk I/O saved: " << zswap.loads << " reads, " << zswap.stores - zswap.writebacks << " writes\n";
+        }
+        if (ksm.pagesToScan > 0 || ksmMerges > 0) {
+            size_t sharing = 0;
+            for (const auto& merged : mergedFrames) sharing += merged.second.pages.size() - 1;
+            std::cout << "Same-page merging: " << mergedFrames.size() << " shared frames, " << sharing
+                      << " frames saved (" << sharing * pageSize << " bytes)\n";
+            std::cout << "Pages scanned: " << ksmScanned << " (" << ksmFullScans << " full scans), merges: " << ksmMerges
+                      << ", unmerges: " << ksmUnmerges << '\n';
+            std::cout << "Scan cost: " << ksmScanTimeNs << " ns";
+            if (simTimeNs() > 0) std::cout << " (" << (100.0 * ksmScanTimeNs / simTimeNs()) << "% of simulated time)";
+            std::cout << '\n';
+        }
+        if (segAllocs + segAllocFailures + segFrees > 0) {
+            size_t freeTotal = freePages(), largest = 0, internal = 0;
+            for (const auto& hole : holes) largest = std::max(largest, hole.second);
+            for (const auto& seg : segments) {
+                if (seg.inUse) internal += segmentPages(seg) * pageSize - seg.limit;
+            }
+            std::cout << "Segment allocations: " << segAllocs << " (" << segAllocFailures << " failed), frees: " << segFrees
+                      << ", compactions: " << compactions << " (" << segmentsMoved << " segments moved)\n";
+            std::cout << "Free address space: " << freeTotal << " pages in " << holes.size() << " holes, largest "
+                      << largest << " pages\n";
+            if (freeTotal > 0)
+                std::cout << "External fragmentation: " << (100.0 * (freeTotal - largest) / freeTotal) << "%\n";
+            std::cout << "Internal fragmentation: " << internal << " bytes\n";
+            size_t attempts = segAllocs + segAllocFailures;
+            if (attempts > 0)
+                std::cout << "Average allocation: " << (1.0 * holesScanned / attempts) << " holes scanned, "
+                          << segAllocTimeNs / attempts << " ns\n";
+        }
+        size_t fastHits = 0, lookups = vaLookups, lookupHits = vaCacheHits;
+        for (const std::unique_ptr<CpuState>& state : cpus) {
+            fastHits += state->fastHits;
+            lookups += state->vaLookups;
+            lookupHits += state->vaCacheHits;
+        }
+        if (cpus.size() > 1 || batchDrains > 0) {
+            std::cout << "Concurrency: " << cpus.size() << " simulated CPUs, " << fastHits << " lock-free hits, "
+                      << accesses - fastHits << " accesses on the locked slow path, " << batchDrains << " hit batches applied\n";
+            std::cout << "Epoch reclamation: " << gracePeriods << " grace periods, " << revocations
+                      << " published translations revoked, " << retiredDirectories.size() << " retired layouts pending\n";
+        }
+        if (lookups > 0) {
+            std::cout << "Virtual address lookups: " << lookups << " over " << segmentIndex.size() << " segments ("
+                      << (100.0 * lookupHits / lookups) << "% served by the last-hit cache)\n";
+        }
+        if (segGrowths + segGrowthFailures > 0) {
+            std::cout << "Segment growth: " << segGrowths << " times, " << segGrowthPages << " pages added, "
+                      << segGrowthFailures << " blocked\n";
+            std::cout << "Page-table population cost: " << growthTimeNs << " ns\n";
+        }
+    }
+
+    void setVerbose(bool v) {
+        ExclusiveGuard guard(*this);
+        verbose = v;
+    }
+
+    /**
+     * @brief Create a segment of arbitrary size, placed by the fit policy at a multiple of its page size
+     *
+     * When no hole is large enough but enough pages are free in total, the address
+     * space is compacted first. Allocation latency is modeled as the holes examined
+     * plus a descriptor update for every segment moved by compaction.
+     * @param pageFrames Base pages per page of the new segment
+     * @return Index of the new segment, or -1 if it does not fit
+     */
+    long createSegment(const std::string& name, size_t size, size_t pageFrames = 1) {
+        ExclusiveGuard guard(*this);
+        const double HOLE_SCAN_NS = 10.0;
+        const double SEGMENT_MOVE_NS = 200.0;
+        if (pageFrames == 0 || pageFrames > fastFrames) {
+            ++segAllocFailures;
+            return -1;
+        }
+        size_t entries = (size + pageFrames * pageSize - 1) / (pageFrames * pageSize);
+        size_t need = entries * pageFrames;
+        size_t scanned = 0, first = 0;
+        size_t movedBefore = segmentsMoved;
+        bool found = findHole(need, pageFrames, scanned, first);
+        if (!found && need > 0 && need <= freePages()) {
+            compact();
+            found = findHole(need, pageFrames, scanned, first);
+        }
+        holesScanned += scanned;
+        segAllocTimeNs += scanned * HOLE_SCAN_NS + (segmentsMoved - movedBefore) * SEGMENT_MOVE_NS;
+        if (need == 0 || !found) {
+            ++segAllocFailures;
+            return -1;
+        }
+        claimRange(first, need);
+        nextFitPage = first + need;
+        ++segAllocs;
+        size_t idx = 0;
+        while (idx < segments.size() && segments[idx].inUse) ++idx;
+        if (idx < segments.size()) segments[idx] = Segment(name, first * pageSize, size, entries, pageFrames);
+        else segments.emplace_back(name, first * pageSize, size, entries, pageFrames);
+        segmentIndex[first * pageSize] = idx;
+        rebuildHitTables();
+        return static_cast<long>(idx);
+    }
+
+    /**
+     * @brief Destroy a segment, discarding its pages and returning its address range to the free holes
+     */
+    bool destroySegment(size_t segIdx) {
+        ExclusiveGuard guard(*this);
+        if (segIdx >= segments.size() || !segments[segIdx].inUse) return false;
+        Segment& seg = segments[segIdx];
+        for (size_t vpn = 0; vpn < seg.pageTable.size(); ++vpn) discardPage(pageKey(segIdx, vpn));
+        releaseRange(seg.base / pageSize, segmentPages(seg));
+        segmentIndex.erase(seg.base);
+        seg.inUse = false;
+        seg.limit = 0;
+        seg.pageTable.clear();
+        ++segFrees;
+        rebuildHitTables();
+        return true;
+    }
+
+    /**
+     * @brief Change an anonymous segment's page size; only allowed before any of its pages is loaded or swapped
+     *
+     * The segment is moved if its base is not a multiple of the new page size or
+     * rounding its limit up to whole pages needs more address space.
+     */
+    bool setSegmentPageSize(size_t segIdx, size_t bytes) {
+        ExclusiveGuard guard(*this);
+        if (segIdx >= segments.size() || !segments[segIdx].inUse || bytes == 0 || bytes % pageSize != 0) return false;
+        Segment& seg = segments[segIdx];
+        size_t frames = bytes / pageSize;
+        if (frames > fastFrames || seg.file >= 0) return false;
+        for (size_t vpn = 0; vpn < seg.pageTable.size(); ++vpn) {
+            PageKey page = pageKey(segIdx, vpn);
+            if (seg.pageTable[vpn].valid || swapStore.count(page) || zswap.contains(page)) return false;
+        }
+        size_t first = seg.base / pageSize, count = segmentPages(seg);
+        size_t entries = (seg.limit + bytes - 1) / bytes;
+        size_t need = entries * frames, start = (first + frames - 1) / frames * frames, scanned = 0;
+        releaseRange(first, count);
+        if (!claimRange(start, need)) {
+            if (!findHole(need, frames, scanned, start)) {
+                claimRange(first, count);
+                return false;
+            }
+            claimRange(start, need);
+        }
+        setSegmentBase(segIdx, start * pageSize);
+        seg.pageFrames = frames;
+        seg.pageTable.assign(entries, PageTableEntry());
+        rebuildHitTables();
+        return true;
+    }
+
+    /**
+     * @brief Address of a segment offset; grows-down segments count offsets down from their top page's end
+     */
+    size_t linearAddress(const Segment& seg, size_t offset) const {
+        if (seg.growth == SegmentGrowth::Down) return seg.base + segmentPages(seg) * pageSize - 1 - offset;
+        return seg.base + offset;
+    }
+
+    /**
+     * @brief Move a segment's base, keeping the address index in step
+     */
+    void setSegmentBase(size_t segIdx, size_t base) {
+        auto it = segmentIndex.find(segments[segIdx].base);
+        if (it != segmentIndex.end() && it->second == segIdx) segmentIndex.erase(it);
+        segments[segIdx].base = base;
+        segmentIndex[base] = segIdx;
+    }
+
+    /**
+     * @brief Offset a virtual address maps to in a segment
+     * @param growth Also accept the growth window just above a grows-up segment or just below a grows-down one
+     * @return false if the address is outside the segment (or its growth window)
+     */
+    bool segmentOffset(size_t segIdx, size_t addr, bool growth, size_t& offset) const {
+        if (segIdx >= segments.size() || !segments[segIdx].inUse) return false;
+        const Segment& seg = segments[segIdx];
+        size_t top = seg.base + segmentPages(seg) * pageSize; // one past the last byte
+        if (seg.growth == SegmentGrowth::Down) {
+            if (addr >= top) return false;
+            offset = top - 1 - addr;
+            return addr >= seg.base || (growth && offset < getSegmentReach(segIdx));
+        }
+        if (addr < seg.base) return false;
+        offset = addr - seg.base;
+        return addr < top || (growth && seg.growth == SegmentGrowth::Up && offset < getSegmentReach(segIdx));
+    }
+
+    /**
+     * @brief Find the segment holding a virtual address
+     *
+     * Segments are kept in a map ordered by base, so a lookup costs O(log n) in the
+     * number of segments; the segment found by the previous lookup is tried first.
+     * An address between segments belongs to the one below if that grows up, or to
+     * the one above if that grows down, when within its growth window.
+     * @return false if no segment maps the address
+     */
+    bool findSegment(size_t addr, size_t& segIdx, size_t& offset) {
+        ++vaLookups;
+        if (segmentOffset(lastHitSeg, addr, false, offset)) {
+            ++vaCacheHits;
+            segIdx = lastHitSeg;
+            return true;
+        }
+        auto next = segmentIndex.upper_bound(addr);
+        size_t below = next != segmentIndex.begin() ? std::prev(next)->second : segments.size();
+        size_t above = next != segmentIndex.end() ? next->second : segments.size();
+        if (segmentOffset(below, addr, false, offset)) {
+            segIdx = lastHitSeg = below;
+        } else if (segmentOffset(below, addr, true, offset)) {
+            segIdx = below;
+        } else if (segmentOffset(above, addr, true, offset)) {
+            segIdx = above;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Lock-free address lookup in the published layout, trying the CPU's last segment first
+     *
+     * Only addresses inside a segment resolve; growth windows and gaps fall back to findSegment.
+     */
+    bool lookupVirtual(size_t addr, size_t cpu, size_t& segIdx, size_t& offset) {
+        if (cpu >= cpus.size() || holdsExclusive()) return false;
+        CpuState& state = *cpus[cpu];
+        ReadSection section(state, globalEpoch);
+        const HitDirectory* dir = hitDirectory.load();
+        if (!dir) return false;
+        auto covers = [&](size_t s) {
+            const HitTable& table = dir->tables[s];
+            if (!table.inUse || addr < table.base || addr >= table.top) return false;
+            offset = table.growsDown ? table.top - 1 - addr : addr - table.base;
+            return true;
+        };
+        if (state.lastHitSeg < dir->tables.size() && covers(state.lastHitSeg)) {
+            ++state.vaLookups;
+            ++state.vaCacheHits;
+            segIdx = state.lastHitSeg;
+            return true;
+        }
+        auto next = std::upper_bound(dir->index.begin(), dir->index.end(), std::make_pair(addr, std::numeric_limits<size_t>::max()));
+        if (next == dir->index.begin() || !covers(std::prev(next)->second)) return false;
+        ++state.vaLookups;
+        segIdx = state.lastHitSeg = std::prev(next)->second;
+        return true;
+    }
+
+    /**
+     * @brief Access a flat virtual address, resolving it to its segment and offset
+     * @return false if no segment maps the address
+     */
+    bool accessVirtual(size_t addr, bool write = false, unsigned char value = 0, size_t cpu = 0) {
+        size_t segIdx, offset;
+        bool found = lookupVirtual(addr, cpu, segIdx, offset);
+        if (!found) {
+            ExclusiveGuard guard(*this);
+            found = findSegment(addr, segIdx, offset);
+        }
+        if (!found) {
+            if (verbose) std::cout << "Address " << addr << " is not mapped!\n";
+            return false;
+        }
+        return accessAddress(segIdx, offset, write, value, cpu);
+    }
+
+    /**
+     * @brief Grow a growable segment to cover an access within the growth window past its limit
+     */
+    bool growOnAccess(size_t segIdx, size_t offset) {
+        const Segment& seg = segments[segIdx];
+        if (seg.growth == SegmentGrowth::None || offset >= seg.limit + growthWindow) return false;
+        size_t newLimit = (offset / pageBytes(seg) + 1) * pageBytes(seg);
+        if (resizeSegment(segIdx, newLimit)) return true;
+        ++segGrowthFailures;
+        return false;
+    }
+
+    /**
+     * @brief Resize a segment (brk): grow or shrink it at its growing end
+     *
+     * Growing needs free address space adjacent to that end and costs populating
+     * the segment's new page-table entries, plus a page-table page for every
+     * 512-entry table first touched. Shrinking discards the pages given up.
+     */
+    bool resizeSegment(size_t segIdx, size_t newLimit) {
+        ExclusiveGuard guard(*this);
+        const double PTE_POPULATE_NS = 50.0;
+        const double TABLE_ALLOC_NS = 500.0;
+        const size_t ENTRIES_PER_TABLE = 512;
+        if (segIdx >= segments.size() || !segments[segIdx].inUse || newLimit == 0) return false;
+        Segment& seg = segments[segIdx];
+        bool down = seg.growth == SegmentGrowth::Down;
+        size_t first = seg.base / pageSize, oldEntries = seg.pageTable.size();
+        size_t newEntries = (newLimit + pageBytes(seg) - 1) / pageBytes(seg);
+        if (newEntries > oldEntries) {
+            size_t extra = (newEntries - oldEntries) * seg.pageFrames;
+            if (down && first < extra) return false;
+            size_t start = down ? first - extra : first + oldEntries * seg.pageFrames;
+            if (!claimRange(start, extra)) return false;
+            size_t tables = 0;
+            for (size_t t = oldEntries / ENTRIES_PER_TABLE; t <= (newEntries - 1) / ENTRIES_PER_TABLE; ++t) {
+                if (t != (oldEntries - 1) / ENTRIES_PER_TABLE) ++tables; // the old last table already exists
+            }
+            growthTimeNs += (newEntries - oldEntries) * PTE_POPULATE_NS + tables * TABLE_ALLOC_NS;
+            if (down) setSegmentBase(segIdx, seg.base - extra * pageSize);
+            seg.pageTable.resize(newEntries);
+            ++segGrowths;
+            segGrowthPages += newEntries - oldEntries;
+        } else if (newEntries < oldEntries) {
+            size_t drop = (oldEntries - newEntries) * seg.pageFrames;
+            for (size_t vpn = newEntries; vpn < oldEntries; ++vpn) discardPage(pageKey(segIdx, vpn));
+            seg.pageTable.resize(newEntries);
+            releaseRange(down ? first : first + newEntries * seg.pageFrames, drop);
+            if (down) setSegmentBase(segIdx, seg.base + drop * pageSize);
+        }
+        seg.limit = newLimit;
+        rebuildHitTables();
+        return true;
+    }
+
+    /**
+     * @brief Set a segment's growth direction and the growth window shared by all segments
+     *
+     * File-backed segments can only grow up, mapping further pages of the file.
+     */
+    bool setSegmentGrowth(size_t segIdx, SegmentGrowth growth, size_t window) {
+        ExclusiveGuard guard(*this);
+        if (segIdx >= segments.size() || !segments[segIdx].inUse) return false;
+        if (growth == SegmentGrowth::Down && segments[segIdx].file >= 0) return false; // file pages map upwards
+        segments[segIdx].growth = growth;
+        growthWindow = window;
+        rebuildHitTables();
+        return true;
+    }
+
+    /**
+     * @brief Take [first, first + count) out of the free holes
+     * @return false if the range is not entirely free
+     */
+    bool claimRange(size_t first, size_t count) {
+        auto hole = holes.upper_bound(first);
+        if (hole == holes.begin()) return false;
+        --hole;
+        size_t holeStart = hole->first, holeEnd = hole->first + hole->second;
+        if (first + count > holeEnd) return false;
+        holes.erase(hole);
+        if (holeStart < first) holes[holeStart] = first - holeStart;
+        if (first + count < holeEnd) holes[first + count] = holeEnd - first - count;
+        return true;
+    }
+
+    /**
+     * @brief Return [first, first + count) to the free holes, coalescing with its neighbours
+     */
+    void releaseRange(size_t first, size_t count) {
+        if (count == 0) return;
+        auto next = holes.lower_bound(first);
+        if (next != holes.end() && next->first == first + count) {
+            count += next->second;
+            holes.erase(next);
+        }
+        auto prev = holes.lower_bound(first);
+        if (prev != holes.begin() && (--prev)->first + prev->second == first) {
+            prev->second += count;
+        } else {
+            holes[first] = count;
+        }
+    }
+
+    void setFitPolicy(FitPolicy fit) {
+        ExclusiveGuard guard(*this);
+        fitPolicy = fit;
+    }
+    size_t getGrowthWindow() const { return growthWindow; }
+
+    /**
+     * @brief Base pages of address space a segment spans
+     */
+    size_t segmentPages(const Segment& seg) const { return seg.pageTable.size() * seg.pageFrames; }
+
+    size_t freePages() const {
+        size_t total = 0;
+        for (const auto& hole : holes) total += hole.second;
+        return total;
+    }
+
+    /**
+     * @brief Find room for need pages starting at a multiple of align, according to the fit policy
+     * @param scanned Incremented by the number of holes examined
+     * @param start Receives the first page of the room found
+     * @return false if no hole has room
+     */
+    bool findHole(size_t need, size_t align, size_t& scanned, size_t& start) {
+        auto fits = [need, align](const std::pair<const size_t, size_t>& hole, size_t& at) {
+            at = (hole.first + align - 1) / align * align;
+            return at + need <= hole.first + hole.second;
+        };
+        if (fitPolicy == FitPolicy::NextFit) {
+            auto it = holes.lower_bound(nextFitPage);
+            for (size_t n = 0; n < holes.size(); ++n) {
+                if (it == holes.end()) it = holes.begin();
+                ++scanned;
+                if (fits(*it, start)) return true;
+                ++it;
+            }
+            return false;
+        }
+        bool found = false;
+        size_t bestLength = 0, at;
+        for (auto it = holes.begin(); it != holes.end(); ++it) {
+            ++scanned;
+            if (!fits(*it, at)) continue;
+            if (fitPolicy == FitPolicy::FirstFit) {
+                start = at;
+                return true;
+            }
+            if (!found || it->second < bestLength) {
+                found = true;
+                bestLength = it->second;
+                start = at;
+            }
+        }
+        return found;
+    }
+
+    /**
+     * @brief Slide every segment down to the lowest free address its page size allows
+     *
+     * Page tables are segment-relative, so a move only updates the segment's base;
+     * no page is remapped.
+     */
+    void compact() {
+        std::vector<size_t> order;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (segments[i].inUse) order.push_back(i);
+        }
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return segments[a].base < segments[b].base; });
+        holes.clear();
+        size_t nextPage = 0;
+        for (size_t idx : order) {
+            Segment& seg = segments[idx];
+            size_t start = (nextPage + seg.pageFrames - 1) / seg.pageFrames * seg.pageFrames;
+            if (start > nextPage) holes[nextPage] = start - nextPage;
+            if (seg.base != start * pageSize) {
+                seg.base = start * pageSize;
+                ++segmentsMoved;
+            }
+            nextPage = start + segmentPages(seg);
+        }
+        if (nextPage < numPages) holes[nextPage] = numPages - nextPage;
+        segmentIndex.clear();
+        for (size_t idx : order) segmentIndex[segments[idx].base] = idx;
+        nextFitPage = nextPage;
+        ++compactions;
+        rebuildHitTables();
+    }
+
+    /**
+     * @brief Drop a virtual page: unmap it, free its frames unless shared or cached, and forget its swapped copy
+     */
+    void discardPage(PageKey page) {
+        PageTableEntry& entry = pte(page);
+        if (entry.locked) --lockedPages;
+        if (entry.valid) {
+            size_t frame = static_cast<size_t>(entry.frameNumber);
+            auto merged = mergedFrames.find(frame);
+            auto cached = cachedFrames.find(frame);
+            if (cached != cachedFrames.end()) { // the file page stays cached
+                std::vector<PageKey>& mappers = cached->second.mappers;
+                mappers.erase(std::find(mappers.begin(), mappers.end(), page));
+                cached->second.dirty = cached->second.dirty || entry.dirty;
+                if (entry.locked) updateEvictable(frame);
+            } else if (merged != mergedFrames.end() && merged->second.pages.size() > 1) {
+                std::vector<PageKey>& sharers = merged->second.pages;
+                sharers.erase(std::find(sharers.begin(), sharers.end(), page));
+                if (frameTable[frame] == page) frameTable[frame] = sharers.front();
+            } else {
+                dissolveMerged(frame);
+                freeFrame(frame);
+            }
+            pteChanged(page);
+        }
+        entry = PageTableEntry();
+        swapStore.erase(page);
+        zswap.erase(page);
+        dirtySince.erase(page);
+        idleEvicted.erase(page);
+    }
+
+    size_t getNumSegments() const { return segments.size(); }
+    bool isSegmentInUse(size_t segIdx) const { return segments[segIdx].inUse; }
+    size_t getSegmentLimit(size_t segIdx) const { return segments[segIdx].limit; }
+
+    /**
+     * @brief Offsets below this are accepted: the limit, plus the growth window for growable segments
+     */
+    size_t getSegmentReach(size_t segIdx) const {
+        const Segment& seg = segments[segIdx];
+        return seg.limit + (seg.growth != SegmentGrowth::None ? growthWindow : 0);
+    }
+    std::string getSegmentName(size_t segIdx) const { return segments[segIdx].name; }
+};
+
+/**
+ * @brief Menu options for the CLI
+ */
+enum MenuOption {
+    SHOW_SEGMENTS = 1,
+    SHOW_PAGETABLE = 2,
+    SHOW_FRAMES = 3,
+    ACCESS_ADDRESS = 4,
+    SHOW_STATS = 5,
+    REPLAY_TRACE = 6,
+    WRITE_ADDRESS = 7,
+    CONFIGURE_ZSWAP = 8,
+    CONFIGURE_KSM = 9,
+    CONFIGURE_PAGING = 10,
+    CREATE_SEGMENT = 11,
+    DESTROY_SEGMENT = 12,
+    RESIZE_SEGMENT = 13,
+    SET_SEGMENT_GROWTH = 14,
+    SET_PAGE_SIZE = 15,
+    ACCESS_VIRTUAL = 16,
+    MAP_FILE = 17,
+    SET_SWAPPINESS = 18,
+    ADVISE_RANGE = 19,
+    LOCK_RANGE = 20,
+    CONFIGURE_RECLAIM = 21,
+    CONFIGURE_WRITEBACK = 22,
+    SET_CLEAN_FIRST = 23,
+    CONFIGURE_DAMON = 24,
+    SHOW_ACCESS_REPORT = 25,
+    CONFIGURE_IDLE_RECLAIM = 26,
+    REPLAY_PARALLEL = 27,
+    CONFIGURE_CORES = 28,
+    CONFIGURE_ASIDS = 29,
+    SET_SEGMENT_SPACE = 30,
+    REPLAY_DIRECTORY = 31,
+    EXIT = 0
+};
+
+void menu() {
+    std::cout << "\nVirtual Memory Manager Simulator\n";
+    std::cout << "1. Show Segments\n";
+    std::cout << "2. Show Page Table\n";
+    std::cout << "3. Show Frames\n";
+    std::cout << "4. Access Address\n";
+    std::cout << "5. Show Statistics\n";
+    std::cout << "6. Replay Trace File\n";
+    std::cout << "7. Write Address\n";
+    std::cout << "8. Configure Compressed Swap\n";
+    std::cout << "9. Configure Same-Page Merging\n";
+    std::cout << "10. Configure Paging and Virtualization\n";
+    std::cout << "11. Create Segment\n";
+    std::cout << "12. Destroy Segment\n";
+    std::cout << "13. Resize Segment (brk)\n";
+    std::cout << "14. Set Segment Growth\n";
+    std::cout << "15. Set Segment Page Size\n";
+    std::cout << "16. Access Virtual Address\n";
+    std::cout << "17. Map File\n";
+    std::cout << "18. Set Swappiness\n";
+    std::cout << "19. Advise Range (madvise)\n";
+    std::cout << "20. Lock/Unlock Range (mlock)\n";
+    std::cout << "21. Configure Background Reclaim (kswapd)\n";
+    std::cout << "22. Configure Dirty Writeback\n";
+    std::cout << "23. Set Clean-First Window (CFLRU)\n";
+    std::cout << "24. Configure Access Monitoring (DAMON)\n";
+    std::cout << "25. Show Access Report\n";
+    std::cout << "26. Configure Proactive Reclaim (idle pages)\n";
+    std::cout << "27. Replay Trace on Multiple CPUs\n";
+    std::cout << "28. Configure Cores and TLB Shootdowns\n";
+    std::cout << "29. Configure ASIDs\n";
+    std::cout << "30. Set Segment Address Space\n";
+    std::cout << "31. Replay Trace Directory (one manager per trace)\n";
+    std::cout << "0. Exit\n";
+    std::cout << "Enter choice: ";
+}
+
+/**
+ * @brief Apply a trace directive (a line that does not start with a segment index)
+ *
+ * Supported: "create <name> <size> [first|best|next]", "destroy <segment>",
+ * "brk <segment> <limit>", "grows <segment> up|down|none [window]",
+ * "pagesize <segment> <bytes>", "mmap <file> <offset> <length>",
+ * "swappiness <0-200>",
+ * "madvise <segment> <offset> <length> normal|sequential|random|willneed|dontneed|cold",
+ * "mlock|munlock <segment> [<offset> <length>]" (the whole segment without a range),
+ * "watermarks <min> <low> <high> [batch]",
+ * "writeback <interval> <expire> <background ratio> <dirty ratio>", "cflru <window>",
+ * "damon <sample interval> <aggregate samples> <min regions> <max regions> [cold age]",
+ * "idlereclaim <scan interval> <idle scans>", "shootdown <IPI ns> <handler ns> [batched]",
+ * "asids <n>" and "space <segment> <space>".
+ * @return false if the directive is unknown or fails
+ */
+bool applyDirective(VirtualMemoryManager& vmm, const std::string& cmd, std::istringstream& args) {
+    if (cmd == "create") {
+        std::string name, fit;
+        size_t size;
+        if (!(args >> name >> size)) return false;
+        if (args >> fit) {
+            if (fit == "first") vmm.setFitPolicy(FitPolicy::FirstFit);
+            else if (fit == "best") vmm.setFitPolicy(FitPolicy::BestFit);
+            else if (fit == "next") vmm.setFitPolicy(FitPolicy::NextFit);
+            else return false;
+        }
+        return vmm.createSegment(name, size) >= 0;
+    }
+    if (cmd == "destroy") {
+        size_t segIdx;
+        return (args >> segIdx) && vmm.destroySegment(segIdx);
+    }
+    if (cmd == "brk") {
+        size_t segIdx, limit;
+        return (args >> segIdx >> limit) && vmm.resizeSegment(segIdx, limit);
+    }
+    if (cmd == "grows") {
+        size_t segIdx, window = vmm.getGrowthWindow();
+        std::string dir;
+        size_t given;
+        if (!(args >> segIdx >> dir)) return false;
+        if (args >> given) window = given;
+        if (dir == "up") return vmm.setSegmentGrowth(segIdx, SegmentGrowth::Up, window);
+        if (dir == "down") return vmm.setSegmentGrowth(segIdx, SegmentGrowth::Down, window);
+        if (dir == "none") return vmm.setSegmentGrowth(segIdx, SegmentGrowth::None, window);
+        return false;
+    }
+    if (cmd == "mmap") {
+        std::string file;
+        size_t offset, length;
+        return (args >> file >> offset >> length) && vmm.mapFile(file, offset, length) >= 0;
+    }
+    if (cmd == "madvise") {
+        static const char* const names[] = {"normal", "sequential", "random", "willneed", "dontneed", "cold"};
+        size_t segIdx, offset, length;
+        std::string hint;
+        if (!(args >> segIdx >> offset >> length >> hint)) return false;
+        for (int i = 0; i < 6; ++i) {
+            if (hint == names[i]) return vmm.madvise(segIdx, offset, length, static_cast<Advice>(i));
+        }
+        return false;
+    }
+    if (cmd == "mlock" || cmd == "munlock") {
+        size_t segIdx, offset = 0, length = std::numeric_limits<size_t>::max();
+        if (!(args >> segIdx)) return false;
+        if (args >> offset && !(args >> length)) return false;
+        return vmm.mlock(segIdx, offset, length, cmd == "mlock");
+    }
+    if (cmd == "watermarks") {
+        ReclaimConfig cfg;
+        if (!(args >> cfg.minFrames >> cfg.lowFrames >> cfg.highFrames)) return false;
+        size_t batch;
+        if (args >> batch) cfg.batch = batch;
+        vmm.configureReclaim(cfg);
+        return true;
+    }
+    if (cmd == "writeback") {
+        WritebackConfig cfg;
+        if (!(args >> cfg.interval >> cfg.expireAccesses >> cfg.backgroundRatio >> cfg.dirtyRatio)) return false;
+        vmm.configureWriteback(cfg);
+        return true;
+    }
+    if (cmd == "cflru") {
+        size_t window;
+        if (!(args >> window)) return false;
+        vmm.setCleanFirstWindow(window);
+        return true;
+    }
+    if (cmd == "damon") {
+        DamonConfig cfg;
+        if (!(args >> cfg.sampleInterval >> cfg.aggregateSamples >> cfg.minRegions >> cfg.maxRegions)) return false;
+        size_t coldAge;
+        if (args >> coldAge) cfg.coldAge = coldAge;
+        vmm.configureDamon(cfg);
+        return true;
+    }
+    if (cmd == "idlereclaim") {
+        IdleReclaimConfig cfg;
+        if (!(args >> cfg.scanInterval >> cfg.idleScans)) return false;
+        vmm.configureIdleReclaim(cfg);
+        return true;
+    }
+    if (cmd == "shootdown") {
+        ShootdownConfig cfg;
+        if (!(args >> cfg.ipiNs >> cfg.handlerNs)) return false;
+        std::string mode;
+        if (args >> mode) {
+            if (mode != "batched") return false;
+            cfg.batchReclaim = true;
+        }
+        vmm.configureShootdowns(cfg);
+        return true;
+    }
+    if (cmd == "asids") {
+        size_t count;
+        if (!(args >> count)) return false;
+        vmm.setAsids(count);
+        return true;
+    }
+    if (cmd == "space") {
+        size_t segIdx, space;
+        return (args >> segIdx >> space) && vmm.setSegmentSpace(segIdx, space);
+    }
+    if (cmd == "swappiness") {
+        unsigned value;
+        if (!(args >> value) || value > 200) return false;
+        vmm.setSwappiness(value);
+        return true;
+    }
+    if (cmd == "pagesize") {
+        size_t segIdx, bytes;
+        return (args >> segIdx >> bytes) && vmm.setSegmentPageSize(segIdx, bytes);
+    }
+    return false;
+}
+
+/**
+ * @brief Parse a "@<core>" access prefix
+ */
+bool lineCore(const std::string& tag, size_t& core) {
+    if (tag.size() < 2 || tag[0] != '@') return false;
+    for (size_t i = 1; i < tag.size(); ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(tag[i]))) return false;
+    }
+    std::istringstream(tag.substr(1)) >> core;
+    return true;
+}
+
+/**
+ * @brief Replay one trace line, '#' starts a comment
+ *
+ * The line is "<segment> <offset>" for a read or "<segment> <offset> w [value]" for a
+ * write; "va <address> [w [value]]" accesses a flat virtual address instead. The
+ * written byte defaults to the low byte of the offset or address. An access may be
+ * prefixed with "@<core>" to run it on that core. Other lines are directives (see
+ * applyDirective).
+ * @param cpu Simulated CPU making the access unless the line names one
+ * @return 1 for a replayed access, 0 for a blank line or applied directive, -1 for an invalid line
+ */
+int replayLine(VirtualMemoryManager& vmm, const std::string& text, size_t cpu = 0) {
+    std::istringstream fields(text.substr(0, text.find('#')));
+    size_t segIdx = 0, offset;
+    std::string first;
+    if (!(fields >> first)) return 0; // blank or comment-only line
+    if (first[0] == '@') {
+        if (!lineCore(first, cpu) || cpu >= vmm.getCpus() || !(fields >> first)) return -1;
+    }
+    bool flat = first == "va";
+    if (!flat && !std::isdigit(static_cast<unsigned char>(first[0]))) return applyDirective(vmm, first, fields) ? 0 : -1;
+    if (!flat) std::istringstream(first) >> segIdx;
+    if (!(fields >> offset)) return -1;
+    std::string op;
+    unsigned value = offset & 0xFF;
+    bool write = false;
+    if (fields >> op) {
+        unsigned given;
+        write = (op == "w");
+        if (write && fields >> given) value = given;
+        if (!write || value > 255) return -1;
+    }
+    bool ok = flat ? vmm.accessVirtual(offset, write, static_cast<unsigned char>(value), cpu)
+                   : vmm.accessAddress(segIdx, offset, write, static_cast<unsigned char>(value), cpu);
+    return ok ? 1 : -1;
+}
+
+/**
+ * @brief Replay an access trace line by line (see replayLine)
+ * @return Number of accesses replayed, or -1 if the file cannot be opened
+ */
+long replayTrace(VirtualMemoryManager& vmm, const std::string& path, size_t& rejected) {
+    std::ifstream in(path.c_str());
+    if (!in) return -1;
+    long replayed = 0;
+    rejected = 0;
+    std::string line;
+    vmm.setVerbose(false);
+    while (std::getline(in, line)) {
+        int result = replayLine(vmm, line);
+        if (result > 0) ++replayed;
+        else if (result < 0) ++rejected;
+    }
+    vmm.setVerbose(true);
+    return replayed;
+}
+
+/**
+ * @brief Replay an access trace on several simulated CPUs, one thread each
+ *
+ * Directives before the first access set the scene on one CPU; the remaining lines
+ * are dealt out to the CPUs in turn (a line naming its core goes to that core) and
+ * replayed concurrently, so later directives take effect whenever their CPU reaches them.
+ * @param wallMs Set to the wall-clock time of the concurrent part
+ * @return Number of accesses replayed, or -1 if the file cannot be opened
+ */
+long replayTraceParallel(VirtualMemoryManager& vmm, const std::string& path, size_t cpus, size_t& rejected, double& wallMs) {
+    std::ifstream in(path.c_str());
+    if (!in) return -1;
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    vmm.setCpus(cpus);
+    cpus = vmm.getCpus();
+    vmm.setVerbose(false);
+    std::atomic<long> replayed(0);
+    std::atomic<size_t> invalid(0);
+    size_t setup = 0;
+    for (; setup < lines.size(); ++setup) {
+        std::istringstream fields(lines[setup].substr(0, lines[setup].find('#')));
+        std::string first;
+        if ((fields >> first) && (first == "va" || first[0] == '@' || std::isdigit(static_cast<unsigned char>(first[0])))) break;
+        if (replayLine(vmm, lines[setup]) < 0) ++invalid;
+    }
+    std::vector<std::vector<size_t>> dealt(cpus);
+    for (size_t i = setup, next = 0; i < lines.size(); ++i) {
+        std::istringstream fields(lines[i]);
+        std::string first;
+        size_t core;
+        if ((fields >> first) && lineCore(first, core) && core < cpus) dealt[core].push_back(i);
+        else dealt[next++ % cpus].push_back(i);
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t cpu = 0; cpu < cpus; ++cpu) {
+        threads.emplace_back([&, cpu]() {
+            for (size_t i : dealt[cpu]) {
+                int result = replayLine(vmm, lines[i], cpu);
+                if (result > 0) ++replayed;
+                else if (result < 0) ++invalid;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    vmm.quiesce();
+    vmm.setVerbose(true);
+    rejected = invalid;
+    return replayed;
+}
+
+/**
+ * @brief One trace of a batch replay, run in chunks of lines
+ *
+ * The trace's manager and open stream travel with it, so whichever worker takes the
+ * next chunk carries on from the state the last one left.
+ */
+struct BatchTrace {
+    std::string name;
+    std::string path;
+    size_t bytes;
+    std::unique_ptr<VirtualMemoryManager> vmm; ///< Created by the first chunk, dropped after the last
+    std::ifstream in;
+    size_t lastWorker;
+    bool opened;  ///< Could be read
+    long replayed;
+    size_t rejected;
+    size_t chunks;
+    size_t handoffs; ///< Chunks run by another worker than the previous chunk
+    ReplaySummary result;
+    BatchTrace() : bytes(0), lastWorker(0), opened(false), replayed(0), rejected(0), chunks(0), handoffs(0) {}
+};
+
+/**
+ * @brief Totals of a batch replay
+ */
+struct BatchReport {
+    std::vector<std::unique_ptr<BatchTrace>> traces; ///< By name
+    size_t workers;
+    size_t steals;  ///< Chunks taken from another worker's queue
+    double wallMs;
+    BatchReport() : workers(0), steals(0), wallMs(0.0) {}
+};
+
+/**
+ * @brief Replay every trace in a directory, each in its own manager, on a work-stealing pool
+ *
+ * Traces are sorted largest first and dealt to the workers' queues in turn. A worker
+ * runs the trace at the front of its own queue, or steals the back of another's when
+ * its own is empty, and sleeps while every queue is empty. With chunkLines > 0 a trace
+ * yields after that many lines if a worker is waiting: it goes to the back of its
+ * worker's queue for that worker to steal, and its old worker moves on. Otherwise it
+ * keeps its worker, so only traces in progress hold a manager. All of a trace's state
+ * is in its manager and the chunks run one at a time in file order, so the results do
+ * not depend on the worker count or on who ran which chunk.
+ * @param makeVmm Builds a fresh manager for a trace
+ * @param workers Worker threads, 0 = one per hardware thread
+ * @param chunkLines Lines per chunk, 0 = run each trace in one go
+ * @return false if the directory cannot be read
+ */
+template <typename MakeVmm>
+bool replayTraceDirectory(const std::string& dir, MakeVmm makeVmm, size_t workers, size_t chunkLines, BatchReport& report) {
+    DIR* listing = opendir(dir.c_str());
+    if (!listing) return false;
+    for (dirent* entry = readdir(listing); entry; entry = readdir(listing)) {
+        std::string name = entry->d_name;
+        std::string path = dir + "/" + name;
+        struct stat info;
+        if (name[0] == '.' || stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) continue;
+        std::unique_ptr<BatchTrace> trace(new BatchTrace);
+        trace->name = name;
+        trace->path = path;
+        trace->bytes = static_cast<size_t>(info.st_size);
+        report.traces.push_back(std::move(trace));
+    }
+    closedir(listing);
+    std::vector<BatchTrace*> order;
+    for (std::unique_ptr<BatchTrace>& trace : report.traces) order.push_back(trace.get());
+    std::sort(order.begin(), order.end(), [](const BatchTrace* a, const BatchTrace* b) {
+        return a->bytes != b->bytes ? a->bytes > b->bytes : a->name < b->name;
+    });
+    std::sort(report.traces.begin(), report.traces.end(),
+              [](const std::unique_ptr<BatchTrace>& a, const std::unique_ptr<BatchTrace>& b) { return a->name < b->name; });
+
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    report.workers = workers;
+    std::vector<std::deque<BatchTrace*>> queues(workers);
+    std::vector<std::unique_ptr<std::mutex>> queueLocks;
+    for (size_t i = 0; i < workers; ++i) queueLocks.emplace_back(new std::mutex);
+    for (size_t i = 0; i < order.size(); ++i) queues[i % workers].push_back(order[i]);
+    std::mutex poolLock; ///< Guards sleeping on and signalling workReady
+    std::condition_variable workReady;
+    std::atomic<size_t> remaining(order.size());
+    std::atomic<size_t> queued(order.size()); ///< Raised under poolLock so sleepers cannot miss it
+    std::atomic<size_t> waiting(0);
+    std::atomic<size_t> steals(0);
+
+    auto take = [&](size_t worker) -> BatchTrace* {
+        for (size_t k = 0; k < workers; ++k) {
+            size_t victim = (worker + k) % workers;
+            std::lock_guard<std::mutex> lock(*queueLocks[victim]);
+            if (queues[victim].empty()) continue;
+            BatchTrace* trace = k == 0 ? queues[victim].front() : queues[victim].back();
+            if (k == 0) queues[victim].pop_front();
+            else queues[victim].pop_back();
+            --queued;
+            if (k > 0) ++steals;
+            return trace;
+        }
+        return nullptr;
+    };
+    auto runChunk = [&](BatchTrace* trace, size_t worker) -> bool {
+        if (trace->chunks++ == 0) {
+            trace->in.open(trace->path.c_str());
+            trace->opened = static_cast<bool>(trace->in);
+            if (!trace->opened) return true;
+            trace->vmm = makeVmm();
+            trace->vmm->setVerbose(false);
+        } else if (trace->lastWorker != worker) {
+            ++trace->handoffs;
+        }
+        trace->lastWorker = worker;
+        std::string line;
+        for (size_t n = 0; chunkLines == 0 || n < chunkLines; ++n) {
+            if (!std::getline(trace->in, line)) {
+                trace->result = trace->vmm->summary();
+                trace->vmm.reset();
+                trace->in.close();
+                return true;
+            }
+            int result = replayLine(*trace->vmm, line);
+            if (result > 0) ++trace->replayed;
+            else if (result < 0) ++trace->rejected;
+        }
+        return false;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t worker = 0; worker < workers; ++worker) {
+        threads.emplace_back([&, worker]() {
+            while (true) {
+                BatchTrace* trace = take(worker);
+                if (!trace) {
+                    std::unique_lock<std::mutex> lock(poolLock);
+                    ++waiting;
+                    workReady.wait(lock, [&]() { return remaining == 0 || queued > 0; });
+                    --waiting;
+                    if (remaining == 0) return;
+                    continue;
+                }
+                bool done = runChunk(trace, worker);
+                while (!done && waiting == 0) done = runChunk(trace, worker);
+                if (done) {
+                    std::lock_guard<std::mutex> lock(poolLock);
+                    if (--remaining == 0) workReady.notify_all();
+                    continue;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(*queueLocks[worker]);
+                    queues[worker].push_back(trace);
+                }
+                std::lock_guard<std::mutex> lock(poolLock);
+                ++queued;
+                workReady.notify_one();
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    report.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    report.steals = steals;
+    return true;
+}
+
+/**
+ * @brief Print the aggregate of a batch replay and the traces with the highest fault rates
+ */
+void showBatchReport(const BatchReport& report) {
+    ReplaySummary total;
+    size_t unreadable = 0, rejected = 0, chunks = 0, handoffs = 0;
+    std::vector<const BatchTrace*> ranked;
+    for (const std::unique_ptr<BatchTrace>& trace : report.traces) {
+        chunks += trace->chunks;
+        if (!trace->opened) {
+            ++unreadable;
+            continue;
+        }
+        const ReplaySummary& r = trace->result;
+        total.accesses += r.accesses;
+        total.pageFaults += r.pageFaults;
+        total.majorFaults += r.majorFaults;
+        total.evictions += r.evictions;
+        total.tlbHits += r.tlbHits;
+        total.tlbMisses += r.tlbMisses;
+        total.simNs += r.simNs;
+        rejected += trace->rejected;
+        handoffs += trace->handoffs;
+        ranked.push_back(trace.get());
+    }
+    auto faultRate = [](const ReplaySummary& r) { return r.accesses > 0 ? 100.0 * r.pageFaults / r.accesses : 0.0; };
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\nBatch replay: " << report.traces.size() << " traces";
+    if (unreadable > 0) std::cout << " (" << unreadable << " unreadable)";
+    std::cout << " on " << report.workers << " workers in " << report.wallMs << " ms";
+    if (report.wallMs > 0) std::cout << ", " << 1000.0 * ranked.size() / report.wallMs << " traces per second";
+    std::cout << '\n';
+    std::cout << "Scheduling: " << chunks << " chunks, " << report.steals << " stolen, " << handoffs
+              << " resumed on another worker\n";
+    std::cout << "Accesses: " << total.accesses << " (" << rejected << " invalid lines skipped)\n";
+    std::cout << "Page faults: " << total.pageFaults << " (major " << total.majorFaults << ")";
+    if (total.accesses > 0) std::cout << ", fault rate " << faultRate(total) << "%";
+    std::cout << ", evictions: " << total.evictions << '\n';
+    std::cout << "TLB hits: " << total.tlbHits << ", misses: " << total.tlbMisses;
+    if (total.accesses > 0) std::cout << " (hit ratio " << 100.0 * total.tlbHits / total.accesses << "%)";
+    std::cout << '\n';
+    std::cout << "Simulated time: " << total.simNs << " ns in total";
+    if (!ranked.empty()) std::cout << ", " << total.simNs / ranked.size() << " ns per trace";
+    std::cout << '\n';
+    std::stable_sort(ranked.begin(), ranked.end(), [&](const BatchTrace* a, const BatchTrace* b) {
+        return faultRate(a->result) > faultRate(b->result);
+    });
+    if (ranked.size() > 5) ranked.resize(5);
+    if (!ranked.empty()) std::cout << "Highest fault rates:\n";
+    for (const BatchTrace* trace : ranked) {
+        std::cout << "  " << trace->name << ": " << trace->result.accesses << " accesses, " << trace->result.pageFaults
+                  << " faults (" << faultRate(trace->result) << "%), " << trace->result.simNs << " ns\n";
+    }
+}
+
+/**
+ * @brief Prompt for a segment index and offset
+ * @return false (after reporting it) if either is invalid
+ */
+bool promptAddress(const VirtualMemoryManager& vmm, size_t& segIdx, size_t& offset) {
+    vmm.showSegments();
+    std::cout << "Enter segment index (0-" << vmm.getNumSegments() - 1 << "): ";
+    std::cin >> segIdx;
+    if (!std::cin || segIdx >= vmm.getNumSegments() || !vmm.isSegmentInUse(segIdx)) {
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        std::cout << "Invalid segment index!\n";
+        return false;
+    }
+    std::cout << "Enter offset (0-" << vmm.getSegmentReach(segIdx) - 1 << "): ";
+    std::cin >> offset;
+    if (!std::cin || offset >= vmm.getSegmentReach(segIdx)) {
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        std::cout << "Invalid offset!\n";
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    size_t memSize, pageSize, nSegments;
+    std::cout << "Enter total memory size (bytes): ";
+    std::cin >> memSize;
+    std::cout << "Enter page size (bytes): ";
+    std::cin >> pageSize;
+    size_t physMemSize = 0;
+    std::cout << "Enter physical memory size (bytes, 0 = same as total): ";
+    std::cin >> physMemSize;
+    TieringConfig tiering;
+    std::cout << "Enter fast-tier frames (0 = single tier): ";
+    std::cin >> tiering.fastFrames;
+    if (tiering.fastFrames > 0) {
+        std::cout << "Enter fast-tier and slow-tier latency (ns): ";
+        std::cin >> tiering.fastLatencyNs >> tiering.slowLatencyNs;
+        std::cout << "Enter sampling interval and promotion threshold: ";
+        std::cin >> tiering.sampleInterval >> tiering.promoteThreshold;
+    }
+    std::cout << "Enter number of segments: ";
+    std::cin >> nSegments;
+    std::vector<std::string> segNames;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    for (size_t i = 0; i < nSegments; ++i) {
+        std::string name;
+        std::cout << "Enter name for segment " << i << ": ";
+        std::getline(std::cin, name);
+        if (name.empty()) name = "Segment" + std::to_string(i);
+        segNames.push_back(name);
+    }
+    int polChoice = 0;
+    std::cout << "Select page replacement policy (1 = FIFO, 2 = LRU, 3 = CFLRU): ";
+    std::cin >> polChoice;
+    ReplacementPolicy policy = polChoice == 3 ? ReplacementPolicy::CFLRU : polChoice == 2 ? ReplacementPolicy::LRU : ReplacementPolicy::FIFO;
+    VirtualMemoryManager vmm(memSize, pageSize, segNames, policy, physMemSize, tiering);
+    int choice = -1;
+    while (true) {
+        menu();
+        std::cin >> choice;
+        if (!std::cin) {
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::cout << "Invalid input!\n";
+            continue;
+        }
+        switch (choice) {
+            case SHOW_SEGMENTS:
+                vmm.showSegments();
+                break;
+            case SHOW_PAGETABLE:
+                vmm.showPageTable();
+                break;
+            case SHOW_FRAMES:
+                vmm.showFrames();
+                break;
+            case ACCESS_ADDRESS: {
+                size_t segIdx, offset;
+                if (promptAddress(vmm, segIdx, offset)) vmm.accessAddress(segIdx, offset);
+                break;
+            }
+            case WRITE_ADDRESS: {
+                size_t segIdx, offset;
+                unsigned value;
+                if (!promptAddress(vmm, segIdx, offset)) break;
+                std::cout << "Enter byte value (0-255): ";
+                std::cin >> value;
+                if (!std::cin || value > 255) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid value!\n";
+                    break;
+                }
+                vmm.accessAddress(segIdx, offset, true, static_cast<unsigned char>(value));
+                break;
+            }
+            case CONFIGURE_ZSWAP: {
+                size_t poolBytes;
+                std::cout << "Enter compressed pool size (bytes, 0 = disabled): ";
+                std::cin >> poolBytes;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid size!\n";
+                    break;
+                }
+                vmm.configureZswap(poolBytes > 0, poolBytes);
+                break;
+            }
+            case CONFIGURE_KSM: {
+                KsmConfig ksm;
+                std::cout << "Enter pages per scan (0 = stop scanner), scan interval (accesses) and CPU budget (%): ";
+                std::cin >> ksm.pagesToScan >> ksm.scanInterval >> ksm.cpuBudgetPercent;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid settings!\n";
+                    break;
+                }
+                vmm.configureKsm(ksm);
+                break;
+            }
+            case CONFIGURE_PAGING: {
+                PagingConfig paging;
+                int mode = 1;
+                std::cout << "Select translation mode (1 = Native, 2 = Nested, 3 = Shadow): ";
+                std::cin >> mode;
+                std::cout << "Enter TLB entries: ";
+                std::cin >> paging.tlbEntries;
+                std::cout << "Enter guest and host page-table levels: ";
+                std::cin >> paging.guestLevels >> paging.hostLevels;
+                std::cout << "Use huge pages in host (0/1): ";
+                std::cin >> paging.hostHugePages;
+                std::cout << "Enter base pages per host huge page: ";
+                std::cin >> paging.hugePageFactor;
+                std::cout << "Enter host frames (0 = one per guest frame): ";
+                std::cin >> paging.hostFrames;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid settings!\n";
+                    break;
+                }
+                paging.mode = (mode == 2) ? VirtMode::Nested : (mode == 3) ? VirtMode::Shadow : VirtMode::Native;
+                vmm.configurePaging(paging);
+                break;
+            }
+            case CREATE_SEGMENT: {
+                std::string name;
+                size_t size;
+                int fit = 1;
+                std::cout << "Enter segment name and size (bytes): ";
+                std::cin >> name >> size;
+                std::cout << "Select placement (1 = First-fit, 2 = Best-fit, 3 = Next-fit): ";
+                std::cin >> fit;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input!\n";
+                    break;
+                }
+                vmm.setFitPolicy(fit == 2 ? FitPolicy::BestFit : fit == 3 ? FitPolicy::NextFit : FitPolicy::FirstFit);
+                long idx = vmm.createSegment(name, size);
+                if (idx < 0) std::cout << "Not enough free address space!\n";
+                else std::cout << "Created segment " << idx << ".\n";
+                break;
+            }
+            case DESTROY_SEGMENT: {
+                size_t segIdx;
+                vmm.showSegments();
+                std::cout << "Enter segment index: ";
+                std::cin >> segIdx;
+                if (!std::cin || !vmm.destroySegment(segIdx)) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid segment index!\n";
+                }
+                break;
+            }
+            case RESIZE_SEGMENT: {
+                size_t segIdx, limit;
+                vmm.showSegments();
+                std::cout << "Enter segment index and new limit (bytes): ";
+                std::cin >> segIdx >> limit;
+                if (!std::cin || !vmm.resizeSegment(segIdx, limit)) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Cannot resize segment!\n";
+                }
+                break;
+            }
+            case SET_SEGMENT_GROWTH: {
+                size_t segIdx, window;
+                int growth = 0;
+                vmm.showSegments();
+                std::cout << "Enter segment index: ";
+                std::cin >> segIdx;
+                std::cout << "Select growth (0 = None, 1 = Up, 2 = Down): ";
+                std::cin >> growth;
+                std::cout << "Enter growth window (bytes past the limit): ";
+                std::cin >> window;
+                SegmentGrowth dir = growth == 1 ? SegmentGrowth::Up : growth == 2 ? SegmentGrowth::Down : SegmentGrowth::None;
+                if (!std::cin || !vmm.setSegmentGrowth(segIdx, dir, window)) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input!\n";
+                }
+                break;
+            }
+            case SET_PAGE_SIZE: {
+                size_t segIdx, bytes;
+                vmm.showSegments();
+                std::cout << "Enter segment index and page size (bytes, a multiple of the base page size): ";
+                std::cin >> segIdx >> bytes;
+                if (!std::cin || !vmm.setSegmentPageSize(segIdx, bytes)) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Cannot change page size (segment already in use?)\n";
+                }
+                break;
+            }
+            case ACCESS_VIRTUAL: {
+                size_t addr;
+                vmm.showSegments();
+                std::cout << "Enter virtual address: ";
+                std::cin >> addr;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid address!\n";
+                    break;
+                }
+                vmm.accessVirtual(addr);
+                break;
+            }
+            case MAP_FILE: {
+                std::string file;
+                size_t offset, length;
+                std::cout << "Enter file name, offset (a multiple of the page size) and length (bytes): ";
+                std::cin >> file >> offset >> length;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input!\n";
+                    break;
+                }
+                long idx = vmm.mapFile(file, offset, length);
+                if (idx < 0) std::cout << "Cannot map file!\n";
+                else std::cout << "Mapped " << file << " as segment " << idx << ".\n";
+                break;
+            }
+            case SET_SWAPPINESS: {
+                unsigned value;
+                std::cout << "Enter swappiness (0-200, higher reclaims anonymous pages more): ";
+                std::cin >> value;
+                if (!std::cin || value > 200) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid swappiness!\n";
+                    break;
+                }
+                vmm.setSwappiness(value);
+                break;
+            }
+            case ADVISE_RANGE: {
+                size_t segIdx, offset, length;
+                int hint = 0;
+                vmm.showSegments();
+                std::cout << "Enter segment index, offset and length (bytes): ";
+                std::cin >> segIdx >> offset >> length;
+                std::cout << "Select advice (1 = Normal, 2 = Sequential, 3 = Random, 4 = WillNeed, 5 = DontNeed, 6 = Cold): ";
+                std::cin >> hint;
+                if (!std::cin || hint < 1 || hint > 6 || !vmm.madvise(segIdx, offset, length, static_cast<Advice>(hint - 1))) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input!\n";
+                }
+                break;
+            }
+            case LOCK_RANGE: {
+                size_t segIdx, offset, length;
+                int lock = 0;
+                vmm.showSegments();
+                std::cout << "Enter segment index, offset and length (bytes): ";
+                std::cin >> segIdx >> offset >> length;
+                std::cout << "Lock (1) or unlock (0): ";
+                std::cin >> lock;
+                if (!std::cin || lock < 0 || lock > 1) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input!\n";
+                } else if (!vmm.mlock(segIdx, offset, length, lock == 1)) {
+                    std::cout << "Cannot " << (lock ? "lock" : "unlock") << " range!\n";
+                }
+                break;
+            }
+            case CONFIGURE_RECLAIM: {
+                ReclaimConfig reclaim;
+                std::cout << "Enter min, low and high watermarks (free frames, high 0 = no kswapd): ";
+                std::cin >> reclaim.minFrames >> reclaim.lowFrames >> reclaim.highFrames;
+                std::cout << "Enter reclaim batch (victims per invocation): ";
+                std::cin >> reclaim.batch;
+                std::cout << "Enter cost per invocation, per unmapped page, per I/O submission and per written page (ns): ";
+                std::cin >> reclaim.invocationNs >> reclaim.reclaimNsPerPage >> reclaim.ioSubmitNs >> reclaim.ioPageNs;
+                std::cout << "Enter cost per page read (ns): ";
+                std::cin >> reclaim.ioReadNs;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid settings!\n";
+                    break;
+                }
+                vmm.configureReclaim(reclaim);
+                break;
+            }
+            case CONFIGURE_WRITEBACK: {
+                WritebackConfig writeback;
+                std::cout << "Enter flusher interval (accesses, 0 = off) and dirty expire age (accesses): ";
+                std::cin >> writeback.interval >> writeback.expireAccesses;
+                std::cout << "Enter dirty background ratio and dirty ratio (% of frames, 0 = no throttling): ";
+                std::cin >> writeback.backgroundRatio >> writeback.dirtyRatio;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid settings!\n";
+                    break;
+                }
+                vmm.configureWriteback(writeback);
+                break;
+            }
+            case SET_CLEAN_FIRST: {
+                size_t window;
+                std::cout << "Enter clean-first window (pages, 0 = plain LRU): ";
+                std::cin >> window;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input!\n";
+                    break;
+                }
+                vmm.setCleanFirstWindow(window);
+                break;
+            }
+            case CONFIGURE_DAMON: {
+                DamonConfig damon;
+                std::cout << "Enter sample interval (accesses, 0 = off) and samples per aggregation: ";
+                std::cin >> damon.sampleInterval >> damon.aggregateSamples;
+                std::cout << "Enter minimum and maximum number of regions: ";
+                std::cin >> damon.minRegions >> damon.maxRegions;
+                std::cout << "Enter cold age for proactive reclaim (aggregations, 0 = off): ";
+                std::cin >> damon.coldAge;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid settings!\n";
+                    break;
+                }
+                vmm.configureDamon(damon);
+                break;
+            }
+            case SHOW_ACCESS_REPORT:
+                vmm.showAccessReport();
+                break;
+            case CONFIGURE_IDLE_RECLAIM: {
+                IdleReclaimConfig idle;
+                std::cout << "Enter idle scan interval (accesses, 0 = off) and idle scans before reclaim: ";
+                std::cin >> idle.scanInterval >> idle.idleScans;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid settings!\n";
+                    break;
+                }
+                vmm.configureIdleReclaim(idle);
+                break;
+            }
+            case REPLAY_PARALLEL: {
+                std::string path;
+                size_t cpus;
+                std::cout << "Enter trace file path: ";
+                std::cin >> path;
+                std::cout << "Enter number of simulated CPUs: ";
+                std::cin >> cpus;
+                if (!std::cin || cpus == 0) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input!\n";
+                    break;
+                }
+                size_t rejected = 0;
+                double wallMs = 0.0;
+                long replayed = replayTraceParallel(vmm, path, cpus, rejected, wallMs);
+                if (replayed < 0) {
+                    std::cout << "Cannot open " << path << "!\n";
+                    break;
+                }
+                std::cout << "Replayed " << replayed << " accesses on " << vmm.getCpus() << " CPUs (" << rejected
+                          << " invalid lines skipped) in " << std::fixed << std::setprecision(2) << wallMs << " ms";
+                if (wallMs > 0) std::cout << ", " << replayed / wallMs << " accesses per ms";
+                std::cout << ".\n";
+                break;
+            }
+            case CONFIGURE_CORES: {
+                size_t cores;
+                ShootdownConfig cfg;
+                int batched;
+                std::cout << "Enter number of cores: ";
+                std::cin >> cores;
+                std::cout << "Enter shootdown IPI round trip and handler time (ns): ";
+                std::cin >> cfg.ipiNs >> cfg.handlerNs;
+                std::cout << "Batch shootdowns per reclaim pass (1 = yes, 0 = no): ";
+                std::cin >> batched;
+                if (!std::cin || cores == 0 || cfg.ipiNs < 0 || cfg.handlerNs < 0) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid settings!\n";
+                    break;
+                }
+                cfg.batchReclaim = batched != 0;
+                vmm.setCpus(cores);
+                vmm.configureShootdowns(cfg);
+                break;
+            }
+            case CONFIGURE_ASIDS: {
+                size_t count;
+                std::cout << "Enter ASIDs per core (0 = untagged TLBs, flushed on every context switch): ";
+                std::cin >> count;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid ASID count!\n";
+                    break;
+                }
+                vmm.setAsids(count);
+                break;
+            }
+            case REPLAY_DIRECTORY: {
+                std::string dir;
+                size_t workers, chunkLines;
+                std::cout << "Enter trace directory: ";
+                std::cin >> dir;
+                std::cout << "Enter worker threads (0 = one per hardware thread): ";
+                std::cin >> workers;
+                std::cout << "Enter lines per chunk (0 = never split a trace): ";
+                std::cin >> chunkLines;
+                if (!std::cin) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input!\n";
+                    break;
+                }
+                auto makeVmm = [&]() {
+                    return std::unique_ptr<VirtualMemoryManager>(
+                        new VirtualMemoryManager(memSize, pageSize, segNames, policy, physMemSize, tiering));
+                };
+                BatchReport report;
+                if (!replayTraceDirectory(dir, makeVmm, workers, chunkLines, report)) std::cout << "Cannot open " << dir << "!\n";
+                else showBatchReport(report);
+                break;
+            }
+            case SET_SEGMENT_SPACE: {
+                size_t segIdx, space;
+                std::cout << "Enter segment index and address space: ";
+                std::cin >> segIdx >> space;
+                if (!std::cin || !vmm.setSegmentSpace(segIdx, space)) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid segment!\n";
+                }
+                break;
+            }
+            case SHOW_STATS:
+                vmm.showStats();
+                break;
+            case REPLAY_TRACE: {
+                std::string path;
+                std::cout << "Enter trace file path: ";
+                std::cin >> path;
+                size_t rejected = 0;
+                long replayed = replayTrace(vmm, path, rejected);
+                if (replayed < 0) std::cout << "Cannot open " << path << "!\n";
+                else std::cout << "Replayed " << replayed << " accesses (" << rejected << " invalid lines skipped).\n";
+                break;
+            }
+            case EXIT:
+                std::cout << "Exiting...\n";
+                return 0;
+            default:
+                std::cout << "Invalid choice!\n";
+        }
+    }
+    return 0;
 } 
\ No newline at end of file